@@ -12,13 +12,27 @@
 #include <string_view>
 #endif  // __cplusplus >= 201703L
 
+#if __cplusplus >= 202002L
+#include <span>
+#endif  // __cplusplus >= 202002L
+
 std::string base64_encode     (std::string const& s, bool url = false);
 std::string base64_encode_pem (std::string const& s);
 std::string base64_encode_mime(std::string const& s);
 
+//
+// All decoding functions throw std::runtime_error for a character that is in
+// neither alphabet and std::out_of_range if the input ends one character into
+// a chunk, as the original std::string::at() based decoder did.
+//
 std::string base64_decode(std::string const& s, bool remove_linebreaks = false);
 std::string base64_encode(unsigned char const*, size_t len, bool url = false);
 
+//
+// Exact number of characters base64_encode() produces for len bytes
+//
+size_t base64_encoded_length(size_t len);
+
 #if __cplusplus >= 201703L
 //
 // Interface with std::string_view rather than const std::string&
@@ -30,6 +44,72 @@ std::string base64_encode_pem (std::string_view s);
 std::string base64_encode_mime(std::string_view s);
 
 std::string base64_decode(std::string_view s, bool remove_linebreaks = false);
+
+//
+// Number of bytes base64_decode() produces for s without line breaks. It is
+// exact unless there is padding before the last chunk, otherwise an upper
+// bound.
+//
+size_t base64_decoded_length(std::string_view s);
 #endif  // __cplusplus >= 201703L
 
+#if __cplusplus >= 202002L
+//
+// Interface writing into caller provided buffers, nothing is allocated.
+// Both return the number of characters or bytes written and throw
+// std::length_error if out is shorter than base64_encoded_length(in.size())
+// or base64_decoded_length(s).
+//
+size_t base64_encode(std::span<const unsigned char> in, std::span<char> out, bool url = false);
+size_t base64_decode(std::string_view s, std::span<unsigned char> out);
+
+//
+// Incremental encoder for input arriving in pieces. The output is the same
+// as base64_encode() of the whole input, or base64_encode_pem() and
+// base64_encode_mime() with line_length 64 and 76. After finish() the encoder
+// can be used for new input.
+//
+class base64_encoder {
+public:
+    explicit base64_encoder(bool url = false, size_t line_length = 0);
+
+    //
+    // Room needed in out by update() with in_len bytes, or by finish()
+    // with 0.
+    //
+    size_t max_output(size_t in_len) const;
+
+    size_t update(std::span<const unsigned char> in, std::span<char> out);
+    size_t finish(std::span<char> out);
+
+private:
+    bool url_;
+    size_t line_length_;
+    size_t line_pos_ = 0;
+    unsigned char pending_[3] = {};
+    size_t pending_len_ = 0;
+};
+
+//
+// Incremental decoder for input arriving in pieces, which may be split
+// anywhere. Line breaks are skipped like by base64_decode() with
+// remove_linebreaks. finish() decodes the last incomplete chunk.
+//
+class base64_decoder {
+public:
+    //
+    // Room needed in out by update() with in_len characters followed by
+    // finish().
+    //
+    size_t max_output(size_t in_len) const;
+
+    size_t update(std::string_view in, std::span<unsigned char> out);
+    size_t finish(std::span<unsigned char> out);
+
+private:
+    char pending_[4] = {};
+    size_t pending_len_ = 0;
+};
+#endif  // __cplusplus >= 202002L
+
 #endif /* BASE64_H_C0CE2A47_D10E_42C9_A27C_C883944E704A */
@@ -40,15 +40,43 @@
 #include <cstdio>
 #include <exception>
 #ifndef CSV_IO_NO_THREAD
-#include <mutex>
+#include <atomic>
 #include <thread>
-#include <condition_variable>
 #endif
 #include <memory>
 #include <cassert>
 #include <cerrno>
 #include <istream>
+#include <ostream>
+#include <string_view>
 #include <limits>
+#include <iterator>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+#if !defined(CSV_IO_NO_MMAP) && !defined(__unix__) && !defined(__APPLE__)
+#define CSV_IO_NO_MMAP
+#endif
+#if !defined(CSV_IO_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define CSV_IO_X86_SIMD
+#include <immintrin.h>
+#endif
+#ifdef CSV_IO_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CSV_IO_WITH_ZSTD
+#include <zstd.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define CSV_IO_POSIX
+#include <sys/stat.h>
+#endif
+#ifndef CSV_IO_NO_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace io{
         ////////////////////////////////////////////////////////////////////////////
@@ -128,13 +156,23 @@ namespace io{
                         }
                 };
 
+                struct can_not_decompress_file :
+                        base,
+                        with_file_name{
+                        void format_error_message()const override{
+                                std::snprintf(error_message_buffer, sizeof(error_message_buffer),
+                                        "Can not decompress file \"%s\", it is corrupt or truncated."
+                                        , file_name);
+                        }
+                };
+
                 struct line_length_limit_exceeded :
                         base,
                         with_file_name,
                         with_file_line{
                         void format_error_message()const override{
                                 std::snprintf(error_message_buffer, sizeof(error_message_buffer),
-                                        "Line number %d in file \"%s\" exceeds the maximum length of 2^24-1."
+                                        "Line number %d in file \"%s\" exceeds the maximum length of one read block."
                                         , file_line, file_name);
                         }
                 };
@@ -148,6 +186,128 @@ namespace io{
 
         namespace detail{
 
+                ////////////////////////////////////////////////////////////////////
+                //               Scanning for structural characters               //
+                ////////////////////////////////////////////////////////////////////
+
+                // find_first_of<chars...>(begin, end) returns the first position in
+                // [begin, end) holding one of chars or end if there is none.
+                // find_first_of_or_nul<chars...>(begin) does the same for a NUL
+                // terminated string and stops at the terminator.
+                //
+                // On x86-64 each 16 or 32 byte block is compared against all the
+                // characters at once and the hits are collected in a bitmask. Only
+                // aligned blocks are loaded, so the scan never touches a page that
+                // does not also hold a byte of the input. Line scans pick AVX2 at
+                // runtime if available. Columns are mostly shorter than one block,
+                // so they always use the SSE2 kernel which can be inlined into the
+                // caller. Define CSV_IO_NO_SIMD to get the plain byte loops.
+
+                template<char ... char_list>
+                inline bool is_one_of(char c){
+                        return ((c == char_list) || ...);
+                }
+
+                #ifdef CSV_IO_X86_SIMD
+                template<char ... char_list>
+                struct BlockMaskSSE2{
+                        static const unsigned block_size = 16;
+
+                        __attribute__((no_sanitize_address))
+                        static inline unsigned mask(const char*block){
+                                __m128i data = _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+                                __m128i hits = _mm_setzero_si128();
+                                ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(data, _mm_set1_epi8(char_list)))), ...);
+                                return static_cast<unsigned>(_mm_movemask_epi8(hits));
+                        }
+                };
+
+                template<char ... char_list>
+                struct BlockMaskAVX2{
+                        static const unsigned block_size = 32;
+
+                        __attribute__((target("avx2"), no_sanitize_address))
+                        static inline unsigned mask(const char*block){
+                                __m256i data = _mm256_load_si256(reinterpret_cast<const __m256i*>(block));
+                                __m256i hits = _mm256_setzero_si256();
+                                ((hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(data, _mm256_set1_epi8(char_list)))), ...);
+                                return static_cast<unsigned>(_mm256_movemask_epi8(hits));
+                        }
+                };
+
+                // end == nullptr means that only a hit stops the scan
+                template<class BlockMask>
+                __attribute__((always_inline))
+                inline const char*scan_blocks(const char*begin, const char*end){
+                        const unsigned block_size = BlockMask::block_size;
+                        unsigned misalignment = reinterpret_cast<std::uintptr_t>(begin) & (block_size-1);
+                        const char*block = begin - misalignment;
+                        unsigned mask = BlockMask::mask(block) >> misalignment;
+                        if(mask != 0){
+                                const char*hit = begin + __builtin_ctz(mask);
+                                return end == nullptr || hit < end ? hit : end;
+                        }
+                        for(block += block_size; end == nullptr || block < end; block += block_size){
+                                mask = BlockMask::mask(block);
+                                if(mask != 0){
+                                        const char*hit = block + __builtin_ctz(mask);
+                                        return end == nullptr || hit < end ? hit : end;
+                                }
+                        }
+                        return end;
+                }
+
+                template<char ... char_list>
+                __attribute__((target("avx2")))
+                const char*scan_avx2(const char*begin, const char*end){
+                        return scan_blocks<BlockMaskAVX2<char_list...>>(begin, end);
+                }
+
+                template<char ... char_list>
+                const char*scan_sse2(const char*begin, const char*end){
+                        return scan_blocks<BlockMaskSSE2<char_list...>>(begin, end);
+                }
+
+                inline bool cpu_has_avx2(){
+                        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+                        return has_avx2;
+                }
+
+                template<char ... char_list>
+                inline const char*scan(const char*begin, const char*end){
+                        if(cpu_has_avx2())
+                                return scan_avx2<char_list...>(begin, end);
+                        else
+                                return scan_sse2<char_list...>(begin, end);
+                }
+
+                template<char ... char_list>
+                inline const char*find_first_of(const char*begin, const char*end){
+                        if(begin == end)
+                                return end;
+                        return scan<char_list...>(begin, end);
+                }
+
+                template<char ... char_list>
+                inline const char*find_first_of_or_nul(const char*begin){
+                        return scan_blocks<BlockMaskSSE2<'\0', char_list...>>(begin, nullptr);
+                }
+                #else
+                template<char ... char_list>
+                inline const char*find_first_of(const char*begin, const char*end){
+                        while(begin != end && !is_one_of<char_list...>(*begin))
+                                ++begin;
+                        return begin;
+                }
+
+                template<char ... char_list>
+                inline const char*find_first_of_or_nul(const char*begin){
+                        while(!is_one_of<'\0', char_list...>(*begin))
+                                ++begin;
+                        return begin;
+                }
+                #endif
+
                 class OwningStdIOByteSourceBase : public ByteSourceBase{
                 public:
                         explicit OwningStdIOByteSourceBase(FILE*file):file(file){
@@ -167,6 +327,243 @@ namespace io{
                         FILE*file;
                 };
 
+                // Regular file that is read as it grows. Remembers which file it
+                // opened and the last bytes read from it, so that a file replaced
+                // under the same name, truncated, or truncated and written again
+                // past the old size can be noticed. On POSIX systems the file is
+                // identified by device and inode; on other systems a file opened
+                // by fopen can not be renamed or deleted, only rewritten.
+                class FollowedFile{
+                public:
+                        FollowedFile():file(nullptr), byte_count(0), tail_length(0){}
+                        FollowedFile(const FollowedFile&) = delete;
+                        FollowedFile&operator=(const FollowedFile&) = delete;
+
+                        enum class rotation{none, truncated, replaced};
+
+                        // Keeps the file opened before if file_name can not be opened
+                        bool open(const char*arg_file_name){
+                                FILE*new_file = std::fopen(arg_file_name, "rb");
+                                if(new_file == nullptr)
+                                        return false;
+                                close();
+                                file = new_file;
+                                file_name = arg_file_name;
+                                std::setvbuf(file, 0, _IONBF, 0);
+                                #ifdef CSV_IO_POSIX
+                                struct stat st;
+                                if(::fstat(fileno(file), &st) == 0){
+                                        device = st.st_dev;
+                                        inode = st.st_ino;
+                                }
+                                #endif
+                                byte_count = 0;
+                                tail_length = 0;
+                                return true;
+                        }
+
+                        bool reopen(){
+                                return open(std::string(file_name).c_str());
+                        }
+
+                        bool is_open()const{
+                                return file != nullptr;
+                        }
+
+                        // Returns the number of bytes appended since the last call, up
+                        // to size
+                        int read(char*buffer, int size){
+                                // clear the EOF flag of the last call
+                                std::clearerr(file);
+                                int n = static_cast<int>(std::fread(buffer, 1, size, file));
+                                byte_count += n;
+                                if(n >= max_tail_length){
+                                        std::memcpy(tail, buffer + n - max_tail_length, max_tail_length);
+                                        tail_length = max_tail_length;
+                                }else if(n > 0){
+                                        int kept = std::min(tail_length, max_tail_length - n);
+                                        std::memmove(tail, tail + tail_length - kept, kept);
+                                        std::memcpy(tail + kept, buffer, n);
+                                        tail_length = kept + n;
+                                }
+                                return n;
+                        }
+
+                        // Whether the name now refers to another file, the file got
+                        // shorter than what was read, or the last bytes read changed.
+                        // A missing file is not rotated (yet), its replacement may
+                        // still be created.
+                        rotation check_rotation(){
+                                std::uint64_t size;
+                                #ifdef CSV_IO_POSIX
+                                struct stat st;
+                                if(::stat(file_name.c_str(), &st) != 0)
+                                        return rotation::none;
+                                if(st.st_dev != device || st.st_ino != inode)
+                                        return rotation::replaced;
+                                size = static_cast<std::uint64_t>(st.st_size);
+                                #else
+                                std::error_code ec;
+                                size = std::filesystem::file_size(file_name, ec);
+                                if(ec)
+                                        return rotation::none;
+                                #endif
+                                if(size < byte_count || !is_tail_unchanged())
+                                        return rotation::truncated;
+                                return rotation::none;
+                        }
+
+                        void close(){
+                                if(file != nullptr){
+                                        std::fclose(file);
+                                        file = nullptr;
+                                }
+                        }
+
+                        ~FollowedFile(){
+                                close();
+                        }
+
+                private:
+                        // Rereads the bytes in front of byte_count and seeks back to
+                        // byte_count
+                        bool is_tail_unchanged(){
+                                if(tail_length == 0)
+                                        return true;
+                                char current[max_tail_length];
+                                bool is_unchanged = seek(byte_count - tail_length)
+                                        && std::fread(current, 1, tail_length, file) == static_cast<std::size_t>(tail_length)
+                                        && std::memcmp(current, tail, tail_length) == 0;
+                                seek(byte_count);
+                                return is_unchanged;
+                        }
+
+                        bool seek(std::uint64_t offset){
+                                #ifdef _WIN32
+                                return ::_fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+                                #else
+                                return ::fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+                                #endif
+                        }
+
+                        static const int max_tail_length = 16;
+
+                        FILE*file;
+                        std::string file_name;
+                        #ifdef CSV_IO_POSIX
+                        dev_t device = 0;
+                        ino_t inode = 0;
+                        #endif
+                        std::uint64_t byte_count;
+                        char tail[max_tail_length];
+                        int tail_length;
+                };
+
+                #ifdef CSV_IO_WITH_ZLIB
+                class OwningGzipByteSource : public ByteSourceBase{
+                public:
+                        explicit OwningGzipByteSource(gzFile file):file(file){
+                                gzbuffer(file, 1<<17);
+                        }
+
+                        int read(char*buffer, int size){
+                                int ret = gzread(file, buffer, static_cast<unsigned>(size));
+                                if(ret < size){
+                                        // Z_BUF_ERROR means that the input ended inside a gzip stream
+                                        int err = Z_OK;
+                                        gzerror(file, &err);
+                                        if(ret < 0 || (err != Z_OK && err != Z_STREAM_END))
+                                                throw error::can_not_decompress_file();
+                                }
+                                return ret;
+                        }
+
+                        ~OwningGzipByteSource(){
+                                gzclose(file);
+                        }
+
+                private:
+                        gzFile file;
+                };
+                #endif
+
+                #ifdef CSV_IO_WITH_ZSTD
+                class OwningZstdByteSource : public ByteSourceBase{
+                public:
+                        // Takes ownership of file, also when the constructor throws
+                        explicit OwningZstdByteSource(FILE*file):
+                                file(file),
+                                stream(ZSTD_createDCtx()),
+                                in_buffer_len(ZSTD_DStreamInSize()),
+                                in_buffer(new char[in_buffer_len]),
+                                input{in_buffer.get(), 0, 0},
+                                frame_remaining(0){
+                                std::setvbuf(file, 0, _IONBF, 0);
+                                if(stream == nullptr)
+                                        throw std::bad_alloc();
+                        }
+
+                        int read(char*buffer, int size){
+                                ZSTD_outBuffer output = {buffer, static_cast<std::size_t>(size), 0};
+                                while(output.pos < output.size){
+                                        if(input.pos == input.size){
+                                                input.size = std::fread(in_buffer.get(), 1, in_buffer_len, file.get());
+                                                input.pos = 0;
+                                                if(input.size == 0){
+                                                        if(frame_remaining != 0)
+                                                                throw error::can_not_decompress_file();
+                                                        break;
+                                                }
+                                        }
+                                        frame_remaining = ZSTD_decompressStream(stream.get(), &output, &input);
+                                        if(ZSTD_isError(frame_remaining))
+                                                throw error::can_not_decompress_file();
+                                }
+                                return static_cast<int>(output.pos);
+                        }
+
+                private:
+                        struct file_closer{
+                                void operator()(FILE*file)const{
+                                        std::fclose(file);
+                                }
+                        };
+
+                        struct stream_freer{
+                                void operator()(ZSTD_DCtx*stream)const{
+                                        ZSTD_freeDCtx(stream);
+                                }
+                        };
+
+                        std::unique_ptr<FILE, file_closer>file;
+                        std::unique_ptr<ZSTD_DCtx, stream_freer>stream;
+                        std::size_t in_buffer_len;
+                        std::unique_ptr<char[]>in_buffer;
+                        ZSTD_inBuffer input;
+                        std::size_t frame_remaining;
+                };
+                #endif
+
+                enum class compression{
+                        none,
+                        gzip,
+                        zstd
+                };
+
+                inline bool ends_with(const char*str, const char*suffix){
+                        std::size_t str_len = std::strlen(str);
+                        std::size_t suffix_len = std::strlen(suffix);
+                        return str_len >= suffix_len && std::strcmp(str + str_len - suffix_len, suffix) == 0;
+                }
+
+                inline compression compression_from_file_name(const char*file_name){
+                        if(ends_with(file_name, ".gz"))
+                                return compression::gzip;
+                        if(ends_with(file_name, ".zst") || ends_with(file_name, ".zstd"))
+                                return compression::zstd;
+                        return compression::none;
+                }
+
                 class NonOwningIStreamByteSource : public ByteSourceBase{
                 public:
                         explicit NonOwningIStreamByteSource(std::istream&in):in(in){}
@@ -203,38 +600,160 @@ namespace io{
                         long long remaining_byte_count;
                 };
 
+                #ifndef CSV_IO_NO_MMAP
+                class MemoryMappedFile{
+                public:
+                        MemoryMappedFile():data(nullptr), size(0), valid(false){}
+                        MemoryMappedFile(const MemoryMappedFile&) = delete;
+                        MemoryMappedFile&operator=(const MemoryMappedFile&) = delete;
+
+                        // The mapping is private and writable so that lines can be
+                        // terminated in place without modifying the file on disk.
+                        // Returns false if the file can not be mapped (pipes, devices,
+                        // ...), the caller should then fall back to reading it.
+                        bool open(const char*file_name){
+                                int fd = ::open(file_name, O_RDONLY);
+                                if(fd == -1)
+                                        return false;
+                                struct stat st;
+                                if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+                                        ::close(fd);
+                                        return false;
+                                }
+                                size = static_cast<std::size_t>(st.st_size);
+                                if(size != 0){
+                                        void*addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+                                        if(addr == MAP_FAILED){
+                                                ::close(fd);
+                                                return false;
+                                        }
+                                        ::madvise(addr, size, MADV_SEQUENTIAL);
+                                        data = static_cast<char*>(addr);
+                                }
+                                ::close(fd);
+                                valid = true;
+                                return true;
+                        }
+
+                        bool is_valid()const{
+                                return valid;
+                        }
+
+                        char*begin()const{
+                                return data;
+                        }
+
+                        char*end()const{
+                                return data + size;
+                        }
+
+                        ~MemoryMappedFile(){
+                                if(data != nullptr)
+                                        ::munmap(data, size);
+                        }
+
+                private:
+                        char*data;
+                        std::size_t size;
+                        bool valid;
+                };
+
+                // Every line terminated in a private mapping dirties a private copy
+                // of its page. Hands the pages that lie completely between the start
+                // and the read position back to the kernel from time to time, so that
+                // scanning a huge file does not keep a private copy of all of it
+                // around. Several readers can share a mapping, each releasing only
+                // the pages of its own range.
+                class MappedPageReleaser{
+                public:
+                        MappedPageReleaser():released_end(nullptr){}
+
+                        // Nothing before the first page boundary at or after begin is
+                        // released, that page may still be written by another reader.
+                        void start(char*begin){
+                                std::uintptr_t address = reinterpret_cast<std::uintptr_t>(begin);
+                                released_end = begin + ((page_size() - address % page_size()) % page_size());
+                        }
+
+                        bool is_started()const{
+                                return released_end != nullptr;
+                        }
+
+                        // Releases the pages before pos once there are at least
+                        // granularity bytes of them
+                        void release_before(char*pos, std::size_t granularity = 1<<24){
+                                if(pos < released_end || static_cast<std::size_t>(pos - released_end) < granularity)
+                                        return;
+                                char*release_end = pos - reinterpret_cast<std::uintptr_t>(pos) % page_size();
+                                if(release_end <= released_end)
+                                        return;
+                                ::madvise(released_end, release_end - released_end, MADV_DONTNEED);
+                                released_end = release_end;
+                        }
+
+                private:
+                        static std::size_t page_size(){
+                                static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+                                return size;
+                        }
+
+                        char*released_end;
+                };
+                #endif
+
+                // Keeps calling read until size bytes are read or the source is
+                // exhausted, so that sources returning short reads (pipes,
+                // decompressors) only return a partial block at the end.
+                inline int read_fully(ByteSourceBase&byte_source, char*buffer, int size){
+                        int byte_count = 0;
+                        while(byte_count < size){
+                                int n = byte_source.read(buffer + byte_count, size - byte_count);
+                                if(n <= 0)
+                                        break;
+                                byte_count += n;
+                        }
+                        return byte_count;
+                }
+
                 #ifndef CSV_IO_NO_THREAD
+                // A worker thread reads blocks into a ring of prefetch_count buffers and
+                // stays up to prefetch_count blocks ahead of the parser. The ring is
+                // handed back and forth through two counters, the threads only block
+                // (on the counters themselves) if the ring is full or empty.
                 class AsynchronousReader{
                 public:
-                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source){
-                                std::unique_lock<std::mutex>guard(lock);
+                        AsynchronousReader():block_len(0), buffer_count(0), consumed_count(0), finished(false){}
+
+                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source, int arg_block_len, int arg_buffer_count){
                                 byte_source = std::move(arg_byte_source);
-                                desired_byte_count = -1;
-                                termination_requested = false;
+                                block_len = arg_block_len;
+                                buffer_count = arg_buffer_count;
+                                buffer = std::unique_ptr<char[]>(new char[static_cast<std::size_t>(block_len)*buffer_count]);
+                                byte_count = std::unique_ptr<int[]>(new int[buffer_count]);
                                 worker = std::thread(
                                         [&]{
-                                                std::unique_lock<std::mutex>guard(lock);
-                                                try{
-                                                        for(;;){
-                                                                read_requested_condition.wait(
-                                                                        guard,
-                                                                        [&]{
-                                                                                return desired_byte_count != -1 || termination_requested;
-                                                                        }
-                                                                );
-                                                                if(termination_requested)
-                                                                        return;
-
-                                                                read_byte_count = byte_source->read(buffer, desired_byte_count);
-                                                                desired_byte_count = -1;
-                                                                if(read_byte_count == 0)
-                                                                        break;
-                                                                read_finished_condition.notify_one();
+                                                std::size_t produced_count = 0;
+                                                for(;;){
+                                                        std::size_t consumed = consumed_counter.load(std::memory_order_acquire);
+                                                        while(produced_count - consumed == static_cast<std::size_t>(buffer_count)){
+                                                                consumed_counter.wait(consumed, std::memory_order_acquire);
+                                                                consumed = consumed_counter.load(std::memory_order_acquire);
                                                         }
-                                                }catch(...){
-                                                        read_error = std::current_exception();
+                                                        if(termination_requested.load(std::memory_order_acquire))
+                                                                return;
+
+                                                        int slot = static_cast<int>(produced_count % buffer_count);
+                                                        try{
+                                                                byte_count[slot] = read_fully(*byte_source, buffer.get() + static_cast<std::size_t>(slot)*block_len, block_len);
+                                                        }catch(...){
+                                                                read_error = std::current_exception();
+                                                                byte_count[slot] = -1;
+                                                        }
+                                                        produced_counter.store(++produced_count, std::memory_order_release);
+                                                        produced_counter.notify_one();
+                                                        if(byte_count[slot] < block_len)
+                                                                return;
                                                 }
-                                                read_finished_condition.notify_one();
                                         }
                                 );
                         }
@@ -243,85 +762,121 @@ namespace io{
                                 return byte_source != nullptr;
                         }
 
-                        void start_read(char*arg_buffer, int arg_desired_byte_count){
-                                std::unique_lock<std::mutex>guard(lock);
-                                buffer = arg_buffer;
-                                desired_byte_count = arg_desired_byte_count;
-                                read_byte_count = -1;
-                                read_requested_condition.notify_one();
-                        }
+                        // Copies the next block to out and returns its length, 0 at the end
+                        int read_block(char*out){
+                                if(finished)
+                                        return 0;
 
-                        int finish_read(){
-                                std::unique_lock<std::mutex>guard(lock);
-                                read_finished_condition.wait(
-                                        guard,
-                                        [&]{
-                                                return read_byte_count != -1 || read_error;
-                                        }
-                                );
-                                if(read_error)
+                                std::size_t produced = produced_counter.load(std::memory_order_acquire);
+                                while(produced == consumed_count){
+                                        produced_counter.wait(produced, std::memory_order_acquire);
+                                        produced = produced_counter.load(std::memory_order_acquire);
+                                }
+
+                                int slot = static_cast<int>(consumed_count % buffer_count);
+                                int ret = byte_count[slot];
+                                if(ret == -1)
                                         std::rethrow_exception(read_error);
-                                else
-                                        return read_byte_count;
+                                std::memcpy(out, buffer.get() + static_cast<std::size_t>(slot)*block_len, ret);
+                                finished = ret < block_len;
+
+                                consumed_counter.store(++consumed_count, std::memory_order_release);
+                                consumed_counter.notify_one();
+                                return ret;
                         }
 
                         ~AsynchronousReader(){
                                 if(byte_source != nullptr){
-                                        {
-                                                std::unique_lock<std::mutex>guard(lock);
-                                                termination_requested = true;
-                                        }
-                                        read_requested_condition.notify_one();
+                                        termination_requested.store(true, std::memory_order_release);
+                                        // bump the counter so that a worker waiting for a free buffer wakes up
+                                        consumed_counter.store(consumed_count + buffer_count + 1, std::memory_order_release);
+                                        consumed_counter.notify_one();
                                         worker.join();
                                 }
                         }
 
                 private:
                         std::unique_ptr<ByteSourceBase>byte_source;
-
                         std::thread worker;
 
-                        bool termination_requested;
+                        int block_len;
+                        int buffer_count;
+                        std::unique_ptr<char[]>buffer;
+                        std::unique_ptr<int[]>byte_count;
                         std::exception_ptr read_error;
-                        char*buffer;
-                        int desired_byte_count;
-                        int read_byte_count;
 
-                        std::mutex lock;
-                        std::condition_variable read_finished_condition;
-                        std::condition_variable read_requested_condition;
+                        std::atomic<std::size_t>produced_counter{0};
+                        std::atomic<std::size_t>consumed_counter{0};
+                        std::atomic<bool>termination_requested{false};
+
+                        // only touched by the consuming thread
+                        std::size_t consumed_count;
+                        bool finished;
                 };
                 #endif
 
                 class SynchronousReader{
                 public:
-                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source){
+                        SynchronousReader():block_len(0), finished(false){}
+
+                        void init(std::unique_ptr<ByteSourceBase>arg_byte_source, int arg_block_len, int){
                                 byte_source = std::move(arg_byte_source);
+                                block_len = arg_block_len;
                         }
 
                         bool is_valid()const{
                                 return byte_source != nullptr;
                         }
 
-                        void start_read(char*arg_buffer, int arg_desired_byte_count){
-                                buffer = arg_buffer;
-                                desired_byte_count = arg_desired_byte_count;
-                        }
-
-                        int finish_read(){
-                                return byte_source->read(buffer, desired_byte_count);
+                        int read_block(char*out){
+                                if(finished)
+                                        return 0;
+                                int ret = read_fully(*byte_source, out, block_len);
+                                finished = ret < block_len;
+                                return ret;
                         }
                 private:
                         std::unique_ptr<ByteSourceBase>byte_source;
-                        char*buffer;
-                        int desired_byte_count;
+                        int block_len;
+                        bool finished;
                 };
         }
 
+        // Buffering used by LineReader for sources that are read rather than
+        // mapped. block_len is also the maximum line length. Up to prefetch_count
+        // blocks are read ahead by the worker thread.
+        //
+        // With use_mmap, regular uncompressed files opened by name are memory
+        // mapped instead, the mapped path ignores block_len and prefetch_count.
+        // Only set it for files nobody truncates or rewrites while they are
+        // read: touching a mapped page behind the new end of the file raises
+        // SIGBUS and kills the process, e.g. when a downloader rewrites the file
+        // with CSVWriter. Appending is harmless, the reader sees the file as it
+        // was when it was opened.
+        struct read_options{
+                int block_len = 1<<20;
+                int prefetch_count = 1;
+                bool use_mmap = false;
+        };
+
+        // Tag selecting the LineReader constructor that works in place
+        struct in_place_t{};
+        static const in_place_t in_place{};
+
+        // Tag selecting the LineReader constructor that follows a growing file
+        struct follow_t{};
+        static const follow_t follow{};
+
+        template<unsigned column_count, class trim_policy, class quote_policy, class overflow_policy, class comment_policy>
+        class ParallelCSVReader;
+
         class LineReader{
         private:
-                static const int block_len = 1<<20;
-                std::unique_ptr<char[]>buffer; // must be constructed before (and thus destructed after) the reader!
+                template<unsigned, class, class, class, class>
+                friend class ParallelCSVReader;
+
+                int block_len;
+                std::unique_ptr<char[]>buffer;
                 #ifdef CSV_IO_NO_THREAD
                 detail::SynchronousReader reader;
                 #else
@@ -329,39 +884,240 @@ namespace io{
                 #endif
                 int data_begin;
                 int data_end;
+                // offset of buffer[0] in the file
+                std::uint64_t data_offset;
+
+                #ifndef CSV_IO_NO_MMAP
+                detail::MemoryMappedFile mapping;
+                detail::MappedPageReleaser releaser;
+                #endif
+                detail::FollowedFile followed;
+
+                bool is_in_place;
+                char*in_place_origin;
+                char*in_place_begin;
+                char*in_place_end;
+                std::unique_ptr<char[]>last_line;
 
                 char file_name[error::max_file_name_length+1];
                 unsigned file_line;
 
+                [[noreturn]] static void throw_can_not_open_file(const char*file_name, int errno_value){
+                        error::can_not_open_file err;
+                        err.set_errno(errno_value);
+                        err.set_file_name(file_name);
+                        throw err;
+                }
+
+                // Files ending in .gz or .zst are decompressed on the fly if csv.h is
+                // compiled with CSV_IO_WITH_ZLIB or CSV_IO_WITH_ZSTD respectively.
+                // Decompression happens in ByteSourceBase::read and thus on the
+                // worker thread of the asynchronous reader.
                 static std::unique_ptr<ByteSourceBase> open_file(const char*file_name){
+                        detail::compression compression = detail::compression_from_file_name(file_name);
+
+                        #ifdef CSV_IO_WITH_ZLIB
+                        if(compression == detail::compression::gzip){
+                                errno = 0;
+                                gzFile file = gzopen(file_name, "rb");
+                                if(file == nullptr)
+                                        throw_can_not_open_file(file_name, errno);
+                                return std::unique_ptr<ByteSourceBase>(new detail::OwningGzipByteSource(file));
+                        }
+                        #endif
+
                         // We open the file in binary mode as it makes no difference under *nix
                         // and under Windows we handle \r\n newlines ourself.
                         FILE*file = std::fopen(file_name, "rb");
                         if(file == 0){
                                 int x = errno; // store errno as soon as possible, doing it after constructor call can fail.
-                                error::can_not_open_file err;
-                                err.set_errno(x);
-                                err.set_file_name(file_name);
-                                throw err;
+                                throw_can_not_open_file(file_name, x);
+                        }
+
+                        #ifdef CSV_IO_WITH_ZSTD
+                        if(compression == detail::compression::zstd)
+                                return std::unique_ptr<ByteSourceBase>(new detail::OwningZstdByteSource(file));
+                        #endif
+
+                        if(compression != detail::compression::none){
+                                // Compressed, but the decompressor is not compiled in
+                                std::fclose(file);
+                                throw_can_not_open_file(file_name, ENOTSUP);
                         }
+
                         return std::unique_ptr<ByteSourceBase>(new detail::OwningStdIOByteSourceBase(file));
                 }
 
-                void init(std::unique_ptr<ByteSourceBase>byte_source){
+                void init_file(const char*file_name, const read_options&options){
+                        #ifndef CSV_IO_NO_MMAP
+                        if(options.use_mmap
+                                && detail::compression_from_file_name(file_name) == detail::compression::none
+                                && mapping.open(file_name)){
+                                init_in_place(mapping.begin(), mapping.end());
+                                releaser.start(mapping.begin());
+                                return;
+                        }
+                        #endif
+                        init(open_file(file_name), options);
+                }
+
+                void init_in_place(char*arg_begin, char*arg_end){
+                        file_line = 0;
+                        is_in_place = true;
+                        block_len = 0;
+                        in_place_origin = arg_begin;
+                        in_place_begin = arg_begin;
+                        in_place_end = arg_end;
+                        data_begin = 0;
+                        data_end = 0;
+                        data_offset = 0;
+
+                        // Ignore UTF-8 BOM
+                        if(in_place_end - in_place_begin >= 3 && in_place_begin[0] == '\xEF' && in_place_begin[1] == '\xBB' && in_place_begin[2] == '\xBF')
+                                in_place_begin += 3;
+                }
+
+                char*next_in_place_line(){
+                        if(in_place_begin == in_place_end)
+                                return nullptr;
+
+                        ++file_line;
+
+                        char*ret = in_place_begin;
+                        char*line_end = in_place_begin + (detail::find_first_of<'\n'>(in_place_begin, in_place_end) - in_place_begin);
+                        if(line_end != in_place_end){
+                                in_place_begin = line_end + 1;
+                        }else{
+                                // some files are missing the newline at the end of the
+                                // last line and there is no byte behind the data to
+                                // put the terminator in, so the last line is copied out
+                                std::size_t len = in_place_end - in_place_begin;
+                                last_line.reset(new char[len+1]);
+                                std::memcpy(last_line.get(), in_place_begin, len);
+                                ret = last_line.get();
+                                line_end = ret + len;
+                                in_place_begin = in_place_end;
+                        }
+                        *line_end = '\0';
+
+                        // handle windows \r\n-line breaks
+                        if(line_end != ret && *(line_end-1) == '\r')
+                                *(line_end-1) = '\0';
+
+                        #ifndef CSV_IO_NO_MMAP
+                        if(releaser.is_started() && ret != last_line.get())
+                                releaser.release_before(ret);
+                        #endif
+                        return ret;
+                }
+
+                void next_block(){
+                        std::memcpy(buffer.get(), buffer.get()+block_len, block_len);
+                        data_begin -= block_len;
+                        data_end -= block_len;
+                        data_offset += block_len;
+                        if(reader.is_valid()){
+                                try{
+                                        data_end += reader.read_block(buffer.get()+block_len);
+                                }catch(error::with_file_name&err){
+                                        err.set_file_name(file_name);
+                                        throw;
+                                }
+                        }
+                }
+
+                void init_follow(const char*file_name, const read_options&options){
+                        assert(options.block_len > 0 && options.block_len <= (1<<29));
+
+                        if(!followed.open(file_name)){
+                                int x = errno;
+                                throw_can_not_open_file(file_name, x);
+                        }
+                        file_line = 0;
+                        is_in_place = false;
+                        block_len = options.block_len;
+                        buffer = std::unique_ptr<char[]>(new char[2*block_len+1]);
+                        data_begin = 0;
+                        data_end = 0;
+                        data_offset = 0;
+                }
+
+                // Lines are only returned once their newline was written, the
+                // partial line behind the last newline stays in the buffer until
+                // the rest of it is appended.
+                // Moves the unread data to the front of the buffer and appends what
+                // was written to the file since. Returns where the new bytes start.
+                int read_followed(){
+                        if(data_begin != 0){
+                                std::memmove(buffer.get(), buffer.get() + data_begin, data_end - data_begin);
+                                data_offset += data_begin;
+                                data_end -= data_begin;
+                                data_begin = 0;
+                        }
+                        int old_data_end = data_end;
+                        data_end += followed.read(buffer.get() + data_end, 2*block_len - data_end);
+
+                        // Ignore UTF-8 BOM
+                        if(data_offset == 0 && data_begin == 0 && data_end >= 3 && old_data_end < 3
+                                && buffer[0] == '\xEF' && buffer[1] == '\xBB' && buffer[2] == '\xBF')
+                                data_begin = 3;
+                        return old_data_end;
+                }
+
+                char*next_followed_line(){
+                        char*line_end = buffer.get() + (detail::find_first_of<'\n'>(buffer.get() + data_begin, buffer.get() + data_end) - buffer.get());
+                        if(line_end == buffer.get() + data_end){
+                                int old_data_end = read_followed();
+                                line_end = buffer.get() + (detail::find_first_of<'\n'>(buffer.get() + old_data_end, buffer.get() + data_end) - buffer.get());
+                                if(line_end == buffer.get() + data_end){
+                                        if(data_end == 2*block_len){
+                                                ++file_line;
+                                                error::line_length_limit_exceeded err;
+                                                err.set_file_name(file_name);
+                                                err.set_file_line(file_line);
+                                                throw err;
+                                        }
+                                        return nullptr;
+                                }
+                        }
+
+                        ++file_line;
+                        char*ret = buffer.get() + data_begin;
+                        *line_end = '\0';
+
+                        // handle windows \r\n-line breaks
+                        if(line_end != ret && *(line_end-1) == '\r')
+                                *(line_end-1) = '\0';
+
+                        data_begin = static_cast<int>(line_end - buffer.get()) + 1;
+                        return ret;
+                }
+
+                void init(std::unique_ptr<ByteSourceBase>byte_source, const read_options&options){
+                        assert(options.block_len > 0 && options.block_len <= (1<<29));
+                        assert(options.prefetch_count > 0);
+
                         file_line = 0;
+                        is_in_place = false;
+                        block_len = options.block_len;
 
-                        buffer = std::unique_ptr<char[]>(new char[3*block_len]);
+                        // one spare byte for the terminator of a last line without newline
+                        buffer = std::unique_ptr<char[]>(new char[2*block_len+1]);
                         data_begin = 0;
-                        data_end = byte_source->read(buffer.get(), 2*block_len);
+                        try{
+                                data_end = detail::read_fully(*byte_source, buffer.get(), 2*block_len);
+                        }catch(error::with_file_name&err){
+                                err.set_file_name(file_name);
+                                throw;
+                        }
+                        data_offset = 0;
 
                         // Ignore UTF-8 BOM
                         if(data_end >= 3 && buffer[0] == '\xEF' && buffer[1] == '\xBB' && buffer[2] == '\xBF')
                                 data_begin = 3;
 
-                        if(data_end == 2*block_len){
-                                reader.init(std::move(byte_source));
-                                reader.start_read(buffer.get() + 2*block_len, block_len);
-                        }
+                        if(data_end == 2*block_len)
+                                reader.init(std::move(byte_source), block_len, options.prefetch_count);
                 }
 
         public:
@@ -369,63 +1125,89 @@ namespace io{
                 LineReader(const LineReader&) = delete;
                 LineReader&operator=(const LineReader&) = delete;
 
-                explicit LineReader(const char*file_name){
+                explicit LineReader(const char*file_name, const read_options&options = read_options()){
                         set_file_name(file_name);
-                        init(open_file(file_name));
+                        init_file(file_name, options);
                 }
 
-                explicit LineReader(const std::string&file_name){
+                explicit LineReader(const std::string&file_name, const read_options&options = read_options()){
                         set_file_name(file_name.c_str());
-                        init(open_file(file_name.c_str()));
+                        init_file(file_name.c_str(), options);
                 }
 
-                LineReader(const char*file_name, std::unique_ptr<ByteSourceBase>byte_source){
+                LineReader(const char*file_name, std::unique_ptr<ByteSourceBase>byte_source, const read_options&options = read_options()){
                         set_file_name(file_name);
-                        init(std::move(byte_source));
+                        init(std::move(byte_source), options);
                 }
 
-                LineReader(const std::string&file_name, std::unique_ptr<ByteSourceBase>byte_source){
+                LineReader(const std::string&file_name, std::unique_ptr<ByteSourceBase>byte_source, const read_options&options = read_options()){
                         set_file_name(file_name.c_str());
-                        init(std::move(byte_source));
+                        init(std::move(byte_source), options);
                 }
 
-                LineReader(const char*file_name, const char*data_begin, const char*data_end){
+                LineReader(const char*file_name, const char*data_begin, const char*data_end, const read_options&options = read_options()){
                         set_file_name(file_name);
-                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningStringByteSource(data_begin, data_end-data_begin)));
+                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningStringByteSource(data_begin, data_end-data_begin)), options);
                 }
 
-                LineReader(const std::string&file_name, const char*data_begin, const char*data_end){
+                LineReader(const std::string&file_name, const char*data_begin, const char*data_end, const read_options&options = read_options()){
                         set_file_name(file_name.c_str());
-                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningStringByteSource(data_begin, data_end-data_begin)));
+                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningStringByteSource(data_begin, data_end-data_begin)), options);
                 }
 
-                LineReader(const char*file_name, FILE*file){
+                // Splits the writable range [data_begin, data_end) into lines without
+                // copying it. The newlines in the range are overwritten with '\0'.
+                LineReader(const char*file_name, char*data_begin, char*data_end, in_place_t){
                         set_file_name(file_name);
-                        init(std::unique_ptr<ByteSourceBase>(new detail::OwningStdIOByteSourceBase(file)));
+                        init_in_place(data_begin, data_end);
                 }
 
-                LineReader(const std::string&file_name, FILE*file){
+                LineReader(const std::string&file_name, char*data_begin, char*data_end, in_place_t){
                         set_file_name(file_name.c_str());
-                        init(std::unique_ptr<ByteSourceBase>(new detail::OwningStdIOByteSourceBase(file)));
+                        init_in_place(data_begin, data_end);
                 }
 
-                LineReader(const char*file_name, std::istream&in){
+                // Follows a file that is appended to. next_line returns nullptr once
+                // all complete lines are read, later calls return the lines appended
+                // in the meantime. Only the new bytes are read. Lines may be up to
+                // 2*block_len long, prefetch_count is not used.
+                LineReader(const char*file_name, follow_t, const read_options&options = read_options()){
                         set_file_name(file_name);
-                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningIStreamByteSource(in)));
+                        init_follow(file_name, options);
                 }
 
-                LineReader(const std::string&file_name, std::istream&in){
+                LineReader(const std::string&file_name, follow_t, const read_options&options = read_options()){
                         set_file_name(file_name.c_str());
-                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningIStreamByteSource(in)));
+                        init_follow(file_name.c_str(), options);
                 }
 
-                void set_file_name(const std::string&file_name){
+                LineReader(const char*file_name, FILE*file, const read_options&options = read_options()){
+                        set_file_name(file_name);
+                        init(std::unique_ptr<ByteSourceBase>(new detail::OwningStdIOByteSourceBase(file)), options);
+                }
+
+                LineReader(const std::string&file_name, FILE*file, const read_options&options = read_options()){
                         set_file_name(file_name.c_str());
+                        init(std::unique_ptr<ByteSourceBase>(new detail::OwningStdIOByteSourceBase(file)), options);
                 }
 
-                void set_file_name(const char*file_name){
-                        if(file_name != nullptr){
-                                strncpy(this->file_name, file_name, sizeof(this->file_name));
+                LineReader(const char*file_name, std::istream&in, const read_options&options = read_options()){
+                        set_file_name(file_name);
+                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningIStreamByteSource(in)), options);
+                }
+
+                LineReader(const std::string&file_name, std::istream&in, const read_options&options = read_options()){
+                        set_file_name(file_name.c_str());
+                        init(std::unique_ptr<ByteSourceBase>(new detail::NonOwningIStreamByteSource(in)), options);
+                }
+
+                void set_file_name(const std::string&file_name){
+                        set_file_name(file_name.c_str());
+                }
+
+                void set_file_name(const char*file_name){
+                        if(file_name != nullptr){
+                                strncpy(this->file_name, file_name, sizeof(this->file_name));
                                 this->file_name[sizeof(this->file_name)-1] = '\0';
                         }else{
                                 this->file_name[0] = '\0';
@@ -444,7 +1226,87 @@ namespace io{
                         return file_line;
                 }
 
+                // Byte offset of the next line, counted from the start of the file
+                // (or of the in place range) including a UTF-8 BOM.
+                std::uint64_t get_offset()const{
+                        if(is_in_place)
+                                return in_place_begin - in_place_origin;
+                        return data_offset + data_begin;
+                }
+
+                // Skips forward to the line starting at offset, which becomes line
+                // file_line+1. offset has to be the start of a line as returned by
+                // get_offset. Data that was read already is never re-read, so a
+                // seek to an offset before get_offset() does nothing. Mapped files
+                // jump directly, everything else is read up to offset.
+                void seek(std::uint64_t offset, unsigned file_line){
+                        if(offset <= get_offset())
+                                return;
+                        this->file_line = file_line;
+                        if(followed.is_open()){
+                                while(offset >= data_offset + data_end){
+                                        data_offset += data_end;
+                                        data_begin = 0;
+                                        data_end = followed.read(buffer.get(), 2*block_len);
+                                        if(data_end == 0)
+                                                return;
+                                }
+                                data_begin = static_cast<int>(offset - data_offset);
+                                return;
+                        }
+                        if(is_in_place){
+                                if(offset < static_cast<std::uint64_t>(in_place_end - in_place_origin))
+                                        in_place_begin = in_place_origin + offset;
+                                else
+                                        in_place_begin = in_place_end;
+                                return;
+                        }
+                        for(;;){
+                                if(data_begin >= block_len)
+                                        next_block();
+                                // a short buffer means the source is exhausted
+                                if(offset < data_offset + data_end || data_end < 2*block_len)
+                                        break;
+                                data_begin = data_end;
+                        }
+                        if(offset < data_offset + data_end)
+                                data_begin = static_cast<int>(offset - data_offset);
+                        else
+                                data_begin = data_end;
+                }
+
+                // Only in follow mode. If the file was truncated, rewritten or
+                // replaced under its name (log rotation), starts over at the first line of the file
+                // now found under the name and returns true. Lines still appended
+                // to a replaced file are returned by next_line first, the switch
+                // happens on the first call after they are all read. A partial last
+                // line of the old file is dropped.
+                bool reopen_if_rotated(){
+                        assert(followed.is_open());
+                        detail::FollowedFile::rotation rotation = followed.check_rotation();
+                        if(rotation == detail::FollowedFile::rotation::none)
+                                return false;
+                        if(rotation == detail::FollowedFile::rotation::replaced){
+                                read_followed();
+                                if(detail::find_first_of<'\n'>(buffer.get() + data_begin, buffer.get() + data_end) != buffer.get() + data_end)
+                                        return false;
+                        }
+                        // the new file may vanish again before it is opened
+                        if(!followed.reopen())
+                                return false;
+                        file_line = 0;
+                        data_begin = 0;
+                        data_end = 0;
+                        data_offset = 0;
+                        return true;
+                }
+
                 char*next_line(){
+                        if(is_in_place)
+                                return next_in_place_line();
+                        if(followed.is_open())
+                                return next_followed_line();
+
                         if(data_begin == data_end)
                                 return nullptr;
 
@@ -453,22 +1315,11 @@ namespace io{
                         assert(data_begin < data_end);
                         assert(data_end <= block_len*2);
 
-                        if(data_begin >= block_len){
-                                std::memcpy(buffer.get(), buffer.get()+block_len, block_len);
-                                data_begin -= block_len;
-                                data_end -= block_len;
-                                if(reader.is_valid())
-                                {
-                                        data_end += reader.finish_read();
-                                        std::memcpy(buffer.get()+block_len, buffer.get()+2*block_len, block_len);
-                                        reader.start_read(buffer.get() + 2*block_len, block_len);
-                                }
-                        }
+                        if(data_begin >= block_len)
+                                next_block();
 
-                        int line_end = data_begin;
-                        while(line_end != data_end && buffer[line_end] != '\n'){
-                                ++line_end;
-                        }
+                        int line_end = static_cast<int>(
+                                detail::find_first_of<'\n'>(buffer.get() + data_begin, buffer.get() + data_end) - buffer.get());
 
                         if(line_end - data_begin + 1 > block_len){
                                 error::line_length_limit_exceeded err;
@@ -681,12 +1532,31 @@ namespace io{
                                         , column_content, column_name, file_name, file_line);
                         }
                 };
+
+                struct invalid_timestamp :
+                        base,
+                        with_file_name,
+                        with_file_line,
+                        with_column_name,
+                        with_column_content{
+                        void format_error_message()const override{
+                                std::snprintf(error_message_buffer, sizeof(error_message_buffer),
+                                        R"(The content "%s" of column "%s" in file "%s" in line "%d" is not a valid timestamp.)"
+                                        , column_content, column_name, file_name, file_line);
+                        }
+                };
         }
 
         using ignore_column = unsigned int;
         static const ignore_column ignore_no_column = 0;
         static const ignore_column ignore_extra_column = 1;
         static const ignore_column ignore_missing_column = 2;
+        // Implies ignore_extra_column. Extra columns are skipped by a plain scan
+        // to the next separator, without quote handling or trimming, so only
+        // use it when extra columns never contain a quoted separator. Extra
+        // columns behind the last read one are not looked at at all, parsing
+        // of a row stops at that column and their count is not checked.
+        static const ignore_column skip_extra_column_unquoted = 4;
 
         template<char ... trim_char_list>
         struct trim_chars{
@@ -759,9 +1629,11 @@ namespace io{
         template<char sep>
         struct no_quote_escape{
                 static const char*find_next_column_end(const char*col_begin){
-                        while(*col_begin != sep && *col_begin != '\0')
-                                ++col_begin;
-                        return col_begin;
+                        return detail::find_first_of_or_nul<sep>(col_begin);
+                }
+
+                static const char*skip_column(const char*col_begin){
+                        return detail::find_first_of_or_nul<sep>(col_begin);
                 }
 
                 static void unescape(char*&, char*&){
@@ -772,21 +1644,21 @@ namespace io{
         template<char sep, char quote>
         struct double_quote_escape{
                 static const char*find_next_column_end(const char*col_begin){
-                        while(*col_begin != sep && *col_begin != '\0')
+                        for(;;){
+                                col_begin = detail::find_first_of_or_nul<sep, quote>(col_begin);
                                 if(*col_begin != quote)
+                                        return col_begin;
+                                do{
+                                        col_begin = detail::find_first_of_or_nul<quote>(col_begin+1);
+                                        if(*col_begin == '\0')
+                                                throw error::escaped_string_not_closed();
                                         ++col_begin;
-                                else{
-                                        do{
-                                                ++col_begin;
-                                                while(*col_begin != quote){
-                                                        if(*col_begin == '\0')
-                                                                throw error::escaped_string_not_closed();
-                                                        ++col_begin;
-                                                }
-                                                ++col_begin;
-                                        }while(*col_begin == quote);
-                                }
-                        return col_begin;
+                                }while(*col_begin == quote);
+                        }
+                }
+
+                static const char*skip_column(const char*col_begin){
+                        return detail::find_first_of_or_nul<sep>(col_begin);
                 }
 
                 static void unescape(char*&col_begin, char*&col_end){
@@ -844,6 +1716,69 @@ namespace io{
                 }
         };
 
+        // Column type for timestamps, parsed into milliseconds since the epoch.
+        // A column holding an integer is taken as milliseconds, otherwise it has
+        // to be an ISO 8601 date-time like 2025-11-29T20:30:13.873Z:
+        //
+        //   YYYY-MM-DD[(T| )hh:mm[:ss[.fraction]]][Z|(+|-)hh[:mm]]
+        //
+        // Without zone designator UTC is assumed. Digits of the fraction after
+        // the milliseconds are ignored.
+        //
+        //   in.read_row(io::as_timestamp_ms(candle.openTime), candle.open, ...);
+        //   in.read_batch(n, io::as_timestamp_ms(open_times), opens, ...);
+        struct timestamp_ms{
+                std::int64_t&value;
+        };
+
+        struct timestamp_ms_array{
+                std::int64_t*values;
+
+                const timestamp_ms operator[](std::size_t i)const{
+                        return timestamp_ms{values[i]};
+                }
+        };
+
+        // The wrappers are returned const, a const temporary binds to the T&
+        // parameters of read_row while other temporaries are rejected.
+        inline const timestamp_ms as_timestamp_ms(std::int64_t&value){
+                return timestamp_ms{value};
+        }
+
+        inline timestamp_ms_array as_timestamp_ms(std::int64_t*values){
+                return timestamp_ms_array{values};
+        }
+
+        // Sparse index of a CSV file sorted by a timestamp column, with one entry
+        // for the first row of every bucket_ms wide time bucket. Built by
+        // build_time_index, stored next to the CSV file by write_time_index and
+        // used by CSVReader::seek_to_timestamp. file_size and file_mtime are
+        // those of the indexed file and tell whether the index is stale.
+        struct time_index{
+                struct entry{
+                        std::int64_t timestamp;
+                        // byte offset of the row, as by LineReader::get_offset
+                        std::uint64_t offset;
+                        // number of lines before the row
+                        unsigned file_line;
+                };
+
+                std::string column_name;
+                std::int64_t bucket_ms = 0;
+                std::uint64_t file_size = 0;
+                std::int64_t file_mtime = 0;
+                std::vector<entry>entries;
+
+                // Last entry with a timestamp <= timestamp, nullptr if there is none
+                const entry*find(std::int64_t timestamp)const{
+                        auto i = std::upper_bound(entries.begin(), entries.end(), timestamp,
+                                [](std::int64_t t, const entry&e){return t < e.timestamp;});
+                        if(i == entries.begin())
+                                return nullptr;
+                        return &*(i-1);
+                }
+        };
+
 
         namespace detail{
                 template<class quote_policy>
@@ -864,6 +1799,11 @@ namespace io{
                         }
                 }
 
+                // col_order entries of an extra column read with skip_extra_column_unquoted
+                // and of all the extra columns behind the last read one
+                static const int skipped_column = -2;
+                static const int skipped_rest_of_line = -3;
+
                 template<class trim_policy, class quote_policy>
                 void parse_line(
                         char*line,
@@ -871,8 +1811,15 @@ namespace io{
                         const std::vector<int>&col_order
                 ){
                         for (int i : col_order) {
+                                if(i == skipped_rest_of_line)
+                                        return;
                                 if(line == nullptr)
                                         throw ::io::error::too_few_columns();
+                                if(i == skipped_column){
+                                        line += quote_policy::skip_column(line) - line;
+                                        line = *line != '\0' ? line + 1 : nullptr;
+                                        continue;
+                                }
                                 char*col_begin, *col_end;
                                 chop_next_column<quote_policy>(line, col_begin, col_end);
 
@@ -918,7 +1865,9 @@ namespace io{
                                                 break;
                                         }
                                 if(col_begin){
-                                        if(ignore_policy & ::io::ignore_extra_column)
+                                        if(ignore_policy & ::io::skip_extra_column_unquoted)
+                                                col_order.push_back(skipped_column);
+                                        else if(ignore_policy & ::io::ignore_extra_column)
                                                 col_order.push_back(-1);
                                         else{
                                                 error::extra_column_in_header err;
@@ -927,6 +1876,11 @@ namespace io{
                                         }
                                 }
                         }
+                        if(!col_order.empty() && col_order.back() == skipped_column){
+                                while(!col_order.empty() && col_order.back() == skipped_column)
+                                        col_order.pop_back();
+                                col_order.push_back(skipped_rest_of_line);
+                        }
                         if(!(ignore_policy & ::io::ignore_missing_column)){
                                 for(unsigned i=0; i<column_count; ++i){
                                         if(!found[i]){
@@ -1026,8 +1980,49 @@ namespace io{
                 template<class overflow_policy>void parse(char*col, signed long long &x)
                         {parse_signed_integer<overflow_policy>(col, x);}
 
+                // Largest integer below which all integers are exact in T (saturated
+                // to 64 bits)
+                template<class T>
+                constexpr std::uint64_t max_exact_mantissa(){
+                        return std::numeric_limits<T>::digits >= 64
+                                ? ~std::uint64_t(0)
+                                : std::uint64_t(1) << (std::numeric_limits<T>::digits % 64);
+                }
+
+                // Largest k for which 10^k = 2^k*5^k is exact in T. k is capped at 27,
+                // the last power of five that fits into 64 bits.
+                template<class T>
+                constexpr int max_exact_power_of_ten(){
+                        int k = 0;
+                        std::uint64_t five_pow = 1;
+                        while(k < 27 && five_pow*5 <= max_exact_mantissa<T>()){
+                                five_pow *= 5;
+                                ++k;
+                        }
+                        return k;
+                }
+
+                template<class T>
+                struct exact_powers_of_ten{
+                        static constexpr T value[28] = {
+                                T(1e0L), T(1e1L), T(1e2L), T(1e3L), T(1e4L), T(1e5L), T(1e6L),
+                                T(1e7L), T(1e8L), T(1e9L), T(1e10L), T(1e11L), T(1e12L), T(1e13L),
+                                T(1e14L), T(1e15L), T(1e16L), T(1e17L), T(1e18L), T(1e19L), T(1e20L),
+                                T(1e21L), T(1e22L), T(1e23L), T(1e24L), T(1e25L), T(1e26L), T(1e27L)
+                        };
+                };
+
+                // The number is split into up to 19 significant digits and a power of
+                // ten. If both are exact in T a single multiplication or division
+                // yields the correctly rounded result (Clinger's fast path). All other
+                // numbers are handed to std::from_chars, which is correctly rounded
+                // too (Eisel-Lemire for float and double in current standard libraries).
+                // Accepts ',' as decimal separator and an empty column as 0.
                 template<class T>
                 void parse_float(const char*col, T&x){
+                        const int max_digit_count = 19;
+                        const int max_exponent = max_exact_power_of_ten<T>();
+
                         bool is_neg = false;
                         if(*col == '-'){
                                 is_neg = true;
@@ -1035,55 +2030,89 @@ namespace io{
                         }else if(*col == '+')
                                 ++col;
 
-                        x = 0;
+                        std::uint64_t mantissa = 0;
+                        int digit_count = 0;
+                        int exponent = 0;
+
+                        const char*int_begin = col;
                         while('0' <= *col && *col <= '9'){
-                                int y = *col - '0';
-                                x *= 10;
-                                x += y;
+                                if(digit_count != 0 || *col != '0'){
+                                        if(digit_count < max_digit_count)
+                                                mantissa = 10*mantissa + (*col - '0');
+                                        else
+                                                ++exponent;
+                                        ++digit_count;
+                                }
                                 ++col;
                         }
+                        const char*int_end = col;
 
+                        const char*frac_begin = col;
                         if(*col == '.'|| *col == ','){
                                 ++col;
-                                T pos = 1;
+                                frac_begin = col;
                                 while('0' <= *col && *col <= '9'){
-                                        pos /= 10;
-                                        int y = *col - '0';
+                                        if(digit_count != 0 || *col != '0'){
+                                                if(digit_count < max_digit_count){
+                                                        mantissa = 10*mantissa + (*col - '0');
+                                                        --exponent;
+                                                }
+                                                ++digit_count;
+                                        }else
+                                                --exponent;
                                         ++col;
-                                        x += y*pos;
                                 }
                         }
+                        const char*frac_end = col;
 
+                        int e = 0;
                         if(*col == 'e' || *col == 'E'){
                                 ++col;
-                                int e;
-
                                 parse_signed_integer<set_to_max_on_overflow>(col, e);
-
-                                if(e != 0){
-                                        T base;
-                                        if(e < 0){
-                                                base = T(0.1);
-                                                e = -e;
-                                        }else{
-                                                base = T(10);
-                                        }
-
-                                        while(e != 1){
-                                                if((e & 1) == 0){
-                                                        base = base*base;
-                                                        e >>= 1;
-                                                }else{
-                                                        x *= base;
-                                                        --e;
-                                                }
-                                        }
-                                        x *= base;
-                                }
+                                // keep the sums below far away from overflowing
+                                e = std::max(-100000, std::min(e, 100000));
                         }else{
                                 if(*col != '\0')
                                         throw error::no_digit();
                         }
+                        exponent += e;
+
+                        if(mantissa == 0){
+                                x = 0;
+                        }else if(digit_count <= max_digit_count
+                                && mantissa <= max_exact_mantissa<T>()
+                                && -max_exponent <= exponent && exponent <= max_exponent){
+                                x = static_cast<T>(mantissa);
+                                if(exponent < 0)
+                                        x /= exact_powers_of_ten<T>::value[-exponent];
+                                else
+                                        x *= exact_powers_of_ten<T>::value[exponent];
+                        }else{
+                                // Rewrite the number as <digits>e<exponent> so that from_chars
+                                // sees neither the sign nor a ',' separator.
+                                char short_buffer[48];
+                                std::string long_buffer;
+                                const char*number_begin, *number_end;
+                                if(digit_count <= max_digit_count){
+                                        char*out = std::to_chars(short_buffer, short_buffer + 20, mantissa).ptr;
+                                        *out++ = 'e';
+                                        number_begin = short_buffer;
+                                        number_end = std::to_chars(out, short_buffer + sizeof(short_buffer), exponent).ptr;
+                                }else{
+                                        long_buffer.assign(int_begin, int_end);
+                                        long_buffer.append(frac_begin, frac_end);
+                                        long_buffer += 'e';
+                                        long_buffer += std::to_string(e - static_cast<int>(frac_end - frac_begin));
+                                        number_begin = long_buffer.data();
+                                        number_end = long_buffer.data() + long_buffer.size();
+                                }
+                                if(std::from_chars(number_begin, number_end, x).ec == std::errc::result_out_of_range){
+                                        if(exponent + digit_count > 0)
+                                                x = std::numeric_limits<T>::infinity();
+                                        else
+                                                x = 0;
+                                }
+                        }
 
                         if(is_neg)
                                 x = -x;
@@ -1093,6 +2122,118 @@ namespace io{
                 template<class overflow_policy> void parse(char*col, double&x) { parse_float(col, x); }
                 template<class overflow_policy> void parse(char*col, long double&x) { parse_float(col, x); }
 
+                // Reads exactly digit_count digits, returns false if there are fewer
+                inline bool parse_fixed_digits(const char*&col, int digit_count, unsigned&x){
+                        x = 0;
+                        for(int i=0; i<digit_count; ++i){
+                                unsigned y = static_cast<unsigned char>(col[i]) - '0';
+                                if(y > 9)
+                                        return false;
+                                x = 10*x + y;
+                        }
+                        col += digit_count;
+                        return true;
+                }
+
+                // Days since 1970-01-01 of a proleptic Gregorian date, see
+                // http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+                constexpr std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d){
+                        y -= m <= 2;
+                        const std::int64_t era = (y >= 0 ? y : y-399) / 400;
+                        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+                        const unsigned doy = (153*(m > 2 ? m-3 : m+9) + 2)/5 + d-1;
+                        const unsigned doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+                        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+                }
+
+                constexpr unsigned days_in_month(unsigned y, unsigned m){
+                        if(m == 2)
+                                return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0) ? 29 : 28;
+                        return m == 4 || m == 6 || m == 9 || m == 11 ? 30 : 31;
+                }
+
+                inline bool parse_iso_timestamp_ms(const char*col, std::int64_t&x){
+                        unsigned year, month, day, hour = 0, minute = 0, second = 0, ms = 0;
+                        if(!parse_fixed_digits(col, 4, year) || *col++ != '-'
+                                || !parse_fixed_digits(col, 2, month) || *col++ != '-'
+                                || !parse_fixed_digits(col, 2, day))
+                                return false;
+                        if(month < 1 || month > 12 || day < 1 || day > days_in_month(year, month))
+                                return false;
+
+                        if(*col == 'T' || *col == ' '){
+                                ++col;
+                                if(!parse_fixed_digits(col, 2, hour) || *col++ != ':'
+                                        || !parse_fixed_digits(col, 2, minute))
+                                        return false;
+                                if(*col == ':'){
+                                        ++col;
+                                        if(!parse_fixed_digits(col, 2, second))
+                                                return false;
+                                        if(*col == '.' || *col == ','){
+                                                ++col;
+                                                unsigned scale = 100;
+                                                if(*col < '0' || *col > '9')
+                                                        return false;
+                                                while('0' <= *col && *col <= '9'){
+                                                        ms += (*col - '0') * scale;
+                                                        scale /= 10;
+                                                        ++col;
+                                                }
+                                        }
+                                }
+                                if(hour > 23 || minute > 59 || second > 60)
+                                        return false;
+                        }
+
+                        std::int64_t offset_minutes = 0;
+                        if(*col == 'Z'){
+                                ++col;
+                        }else if(*col == '+' || *col == '-'){
+                                bool is_neg = *col == '-';
+                                ++col;
+                                unsigned offset_hour, offset_minute = 0;
+                                if(!parse_fixed_digits(col, 2, offset_hour))
+                                        return false;
+                                if(*col == ':'){
+                                        ++col;
+                                        if(!parse_fixed_digits(col, 2, offset_minute))
+                                                return false;
+                                }else if(*col != '\0' && !parse_fixed_digits(col, 2, offset_minute)){
+                                        return false;
+                                }
+                                if(offset_hour > 23 || offset_minute > 59)
+                                        return false;
+                                offset_minutes = offset_hour*60 + offset_minute;
+                                if(is_neg)
+                                        offset_minutes = -offset_minutes;
+                        }
+                        if(*col != '\0')
+                                return false;
+
+                        std::int64_t seconds = days_from_civil(year, month, day)*86400
+                                + hour*3600 + minute*60 + second - offset_minutes*60;
+                        x = seconds*1000 + ms;
+                        return true;
+                }
+
+                template<class overflow_policy>
+                void parse(char*col, const timestamp_ms&x){
+                        const char*digits = *col == '-' ? col+1 : col;
+                        if(*digits != '\0' && *find_first_of_or_nul<'-', ':', 'T', ' ', '.'>(digits) == '\0'){
+                                long long ms;
+                                parse_signed_integer<overflow_policy>(col, ms);
+                                x.value = ms;
+                        }else if(!parse_iso_timestamp_ms(col, x.value)){
+                                throw error::invalid_timestamp();
+                        }
+                }
+
+                template<class overflow_policy>
+                void parse(char*col, timestamp_ms&x){
+                        parse<overflow_policy>(col, static_cast<const timestamp_ms&>(x));
+                }
+
                 template<class overflow_policy, class T>
                 void parse(char*col, T&x){
                         // Mute unused variable compiler warning
@@ -1102,7 +2243,7 @@ namespace io{
                         // "sizeof(T)!=sizeof(T)" only when instantiating it. This is why
                         // this strange construct is used.
                         static_assert(sizeof(T)!=sizeof(T),
-                                "Can not parse this type. Only buildin integrals, floats, char, char*, const char* and std::string are supported");
+                                "Can not parse this type. Only buildin integrals, floats, char, char*, const char*, std::string and io::timestamp_ms are supported");
                 }
 
         }
@@ -1122,6 +2263,9 @@ namespace io{
 
                 std::vector<int>col_order;
 
+                // row was split by seek_to_timestamp and not returned yet
+                bool has_pending_row;
+
                 template<class ...ColNames>
                 void set_column_names(std::string s, ColNames...cols){
                         column_names[column_count-sizeof...(ColNames)-1] = std::move(s);
@@ -1136,8 +2280,11 @@ namespace io{
                 CSVReader(const CSVReader&) = delete;
                 CSVReader&operator=(const CSVReader&);
 
+                template<unsigned, class, class, class, class>
+                friend class ParallelCSVReader;
+
                 template<class ...Args>
-                explicit CSVReader(Args&&...args):in(std::forward<Args>(args)...){
+                explicit CSVReader(Args&&...args):in(std::forward<Args>(args)...), has_pending_row(false){
                         std::fill(row, row+column_count, nullptr);
                         col_order.resize(column_count);
                         for(unsigned i=0; i<column_count; ++i)
@@ -1213,7 +2360,94 @@ namespace io{
                         return in.get_file_line();
                 }
 
+                // Byte offset of the next line that was not split yet
+                std::uint64_t get_offset()const{
+                        return in.get_offset();
+                }
+
+                // For a reader constructed with io::follow, see
+                // LineReader::reopen_if_rotated. After it returned true the header
+                // has to be read again.
+                bool reopen_if_rotated(){
+                        if(!in.reopen_if_rotated())
+                                return false;
+                        has_pending_row = false;
+                        return true;
+                }
+
+                // Moves forward to the first row whose timestamp in the column
+                // index.column_name is at or after timestamp (in ms), so that the next
+                // read_row returns it. The rows have to be sorted by that column, which
+                // also has to be one of the columns of this reader. Rows are skipped
+                // without parsing up to the last index entry before timestamp, the
+                // rest of the way only the timestamp column is parsed. Returns false
+                // if no such row is left.
+                bool seek_to_timestamp(const time_index&index, std::int64_t timestamp){
+                        try{
+                                try{
+                                        std::size_t r = std::find(std::begin(column_names), std::end(column_names), index.column_name)
+                                                - std::begin(column_names);
+                                        if(!has_column(index.column_name)){
+                                                error::missing_column_in_header err;
+                                                err.set_column_name(index.column_name.c_str());
+                                                throw err;
+                                        }
+
+                                        const time_index::entry*e = index.find(timestamp);
+                                        if(e != nullptr && e->offset > in.get_offset()){
+                                                in.seek(e->offset, e->file_line);
+                                                has_pending_row = false;
+                                        }
+
+                                        while(next_row()){
+                                                std::int64_t value;
+                                                timestamp_ms col{value};
+                                                try{
+                                                        try{
+                                                                ::io::detail::parse<overflow_policy>(row[r], col);
+                                                        }catch(error::with_column_content&err){
+                                                                err.set_column_content(row[r]);
+                                                                throw;
+                                                        }
+                                                }catch(error::with_column_name&err){
+                                                        err.set_column_name(column_names[r].c_str());
+                                                        throw;
+                                                }
+                                                if(value >= timestamp){
+                                                        has_pending_row = true;
+                                                        return true;
+                                                }
+                                        }
+                                }catch(error::with_file_name&err){
+                                        err.set_file_name(in.get_truncated_file_name());
+                                        throw;
+                                }
+                        }catch(error::with_file_line&err){
+                                err.set_file_line(in.get_file_line());
+                                throw;
+                        }
+                        return false;
+                }
+
         private:
+                bool next_row(){
+                        if(has_pending_row){
+                                has_pending_row = false;
+                                return true;
+                        }
+
+                        char*line;
+                        do{
+                                line = in.next_line();
+                                if(!line)
+                                        return false;
+                        }while(comment_policy::is_comment(line));
+
+                        detail::parse_line<trim_policy, quote_policy>
+                                (line, row, col_order);
+                        return true;
+                }
+
                 void parse_helper(std::size_t){}
 
                 template<class T, class ...ColType>
@@ -1244,16 +2478,8 @@ namespace io{
                                 "too many columns specified");
                         try{
                                 try{
-
-                                        char*line;
-                                        do{
-                                                line = in.next_line();
-                                                if(!line)
-                                                        return false;
-                                        }while(comment_policy::is_comment(line));
-
-                                        detail::parse_line<trim_policy, quote_policy>
-                                                (line, row, col_order);
+                                        if(!next_row())
+                                                return false;
 
                                         parse_helper(0, cols...);
                                 }catch(error::with_file_name&err){
@@ -1267,7 +2493,860 @@ namespace io{
 
                         return true;
                 }
+
+                // Reads up to n rows into column arrays, one array per column with
+                // room for at least n values, and returns the number of rows read.
+                // Fewer than n rows are only returned at the end of the file. If a row
+                // fails to parse, the rows before it are already stored. A column is
+                // anything indexable, usually a pointer.
+                template<class ...ColType>
+                std::size_t read_batch(std::size_t n, ColType...cols){
+                        static_assert(sizeof...(ColType)>=column_count,
+                                "not enough columns specified");
+                        static_assert(sizeof...(ColType)<=column_count,
+                                "too many columns specified");
+                        std::size_t i = 0;
+                        try{
+                                try{
+                                        for(; i<n; ++i){
+                                                if(!next_row())
+                                                        return i;
+
+                                                parse_helper(0, cols[i]...);
+                                        }
+                                }catch(error::with_file_name&err){
+                                        err.set_file_name(in.get_truncated_file_name());
+                                        throw;
+                                }
+                        }catch(error::with_file_line&err){
+                                err.set_file_line(in.get_file_line());
+                                throw;
+                        }
+
+                        return i;
+                }
         };
+
+        ////////////////////////////////////////////////////////////////////////////
+        //                             Parallel CSV                               //
+        ////////////////////////////////////////////////////////////////////////////
+
+        // Reads a whole file with several threads. The file is loaded into memory,
+        // or mapped with read_options::use_mmap (see there for the hazard), the
+        // header is parsed up front and the rest is split at line boundaries into
+        // chunks, each parsed by its own CSVReader in place. Each chunk hands the
+        // mapped pages it is done with back to the kernel.
+        //
+        //   io::ParallelCSVReader<6> in("BTCUSDT_1m.csv");
+        //   in.read_header(io::ignore_extra_column, "open_time", "open", "high", "low", "close", "volume");
+        //   std::vector<vk::Candle> candles = in.read_all<vk::Candle>(
+        //           [](auto&chunk, vk::Candle&c){
+        //                   return chunk.read_row(c.openTime, c.open, c.high, c.low, c.close, c.volume);
+        //           });
+        //
+        // The row reader is called concurrently from all threads. Errors carry the
+        // line number within the whole file, the first one in file order is thrown.
+        template<unsigned column_count,
+                class trim_policy = trim_chars<' ', '\t'>,
+                class quote_policy = no_quote_escape<','>,
+                class overflow_policy = throw_on_overflow,
+                class comment_policy = no_comment
+        >
+        class ParallelCSVReader{
+        public:
+                using ChunkReader = CSVReader<column_count, trim_policy, quote_policy, overflow_policy, comment_policy>;
+
+        private:
+                static const long long min_chunk_len = 1<<20;
+
+                #ifndef CSV_IO_NO_MMAP
+                detail::MemoryMappedFile mapping;
+                #endif
+                std::vector<char>file_data;
+                std::unique_ptr<ChunkReader>header;
+                unsigned chunk_count;
+
+                void load_file(const char*file_name){
+                        std::unique_ptr<ByteSourceBase>byte_source = LineReader::open_file(file_name);
+                        try{
+                                const int block_len = 1<<20;
+                                std::size_t size = 0;
+                                for(;;){
+                                        file_data.resize(size + block_len);
+                                        int byte_count = detail::read_fully(*byte_source, file_data.data() + size, block_len);
+                                        size += byte_count;
+                                        if(byte_count != block_len)
+                                                break;
+                                }
+                                file_data.resize(size);
+                        }catch(error::with_file_name&err){
+                                err.set_file_name(file_name);
+                                throw;
+                        }
+                }
+
+                void init(const char*file_name, unsigned arg_chunk_count, const read_options&options){
+                        char*data_begin, *data_end;
+                        #ifndef CSV_IO_NO_MMAP
+                        if(options.use_mmap
+                                && detail::compression_from_file_name(file_name) == detail::compression::none
+                                && mapping.open(file_name)){
+                                data_begin = mapping.begin();
+                                data_end = mapping.end();
+                        }else
+                        #endif
+                        {
+                                load_file(file_name);
+                                data_begin = file_data.data();
+                                data_end = file_data.data() + file_data.size();
+                        }
+                        header.reset(new ChunkReader(file_name, data_begin, data_end, in_place));
+
+                        chunk_count = arg_chunk_count;
+                        if(chunk_count == 0){
+                                #ifndef CSV_IO_NO_THREAD
+                                chunk_count = std::thread::hardware_concurrency();
+                                #endif
+                                if(chunk_count == 0)
+                                        chunk_count = 1;
+                        }
+                }
+
+        public:
+                ParallelCSVReader() = delete;
+                ParallelCSVReader(const ParallelCSVReader&) = delete;
+                ParallelCSVReader&operator=(const ParallelCSVReader&) = delete;
+
+                // chunk_count == 0 uses one chunk per hardware thread. Only
+                // options.use_mmap is used.
+                explicit ParallelCSVReader(const char*file_name, unsigned chunk_count = 0, const read_options&options = read_options()){
+                        init(file_name, chunk_count, options);
+                }
+
+                explicit ParallelCSVReader(const std::string&file_name, unsigned chunk_count = 0, const read_options&options = read_options()){
+                        init(file_name.c_str(), chunk_count, options);
+                }
+
+                template<class ...ColNames>
+                void read_header(ignore_column ignore_policy, ColNames...cols){
+                        header->read_header(ignore_policy, std::forward<ColNames>(cols)...);
+                }
+
+                template<class ...ColNames>
+                void set_header(ColNames...cols){
+                        header->set_header(std::forward<ColNames>(cols)...);
+                }
+
+                bool has_column(const std::string&name) const {
+                        return header->has_column(name);
+                }
+
+                const char*get_truncated_file_name()const{
+                        return header->get_truncated_file_name();
+                }
+
+                // Parses all remaining rows and returns them per chunk in file order.
+                // read_one(ChunkReader&, T&) reads one row and returns false at the
+                // end of its chunk, usually by forwarding to ChunkReader::read_row.
+                template<class T, class RowReader>
+                std::vector<std::vector<T>> read_chunks(RowReader read_one){
+                        LineReader&in = header->in;
+                        char*body_begin = in.in_place_begin;
+                        char*body_end = in.in_place_end;
+                        in.in_place_begin = in.in_place_end;
+
+                        long long body_len = body_end - body_begin;
+                        unsigned n = chunk_count;
+                        if(body_len / min_chunk_len < n)
+                                n = static_cast<unsigned>(std::max(body_len / min_chunk_len, 1LL));
+
+                        std::vector<char*>chunk_begin(n+1);
+                        chunk_begin[0] = body_begin;
+                        for(unsigned i=1; i<n; ++i){
+                                char*pos = std::max(body_begin + body_len / n * i, chunk_begin[i-1]);
+                                pos += detail::find_first_of<'\n'>(pos, body_end) - pos;
+                                if(pos != body_end)
+                                        ++pos;
+                                chunk_begin[i] = pos;
+                        }
+                        chunk_begin[n] = body_end;
+
+                        std::vector<std::vector<T>>rows(n);
+                        std::vector<unsigned>line_count(n, 0);
+                        std::vector<std::exception_ptr>chunk_error(n);
+
+                        auto parse_chunk = [&](unsigned i){
+                                try{
+                                        ChunkReader chunk(in.get_truncated_file_name(), chunk_begin[i], chunk_begin[i+1], in_place);
+                                        chunk.col_order = header->col_order;
+                                        std::copy(std::begin(header->column_names), std::end(header->column_names), std::begin(chunk.column_names));
+                                        #ifndef CSV_IO_NO_MMAP
+                                        if(mapping.is_valid())
+                                                chunk.in.releaser.start(chunk_begin[i]);
+                                        #endif
+                                        T row;
+                                        while(read_one(chunk, row))
+                                                rows[i].push_back(std::move(row));
+                                        line_count[i] = chunk.get_file_line();
+                                        #ifndef CSV_IO_NO_MMAP
+                                        if(mapping.is_valid())
+                                                chunk.in.releaser.release_before(chunk_begin[i+1], 0);
+                                        #endif
+                                }catch(...){
+                                        chunk_error[i] = std::current_exception();
+                                }
+                        };
+
+                        #ifndef CSV_IO_NO_THREAD
+                        std::vector<std::thread>workers;
+                        try{
+                                for(unsigned i=1; i<n; ++i)
+                                        workers.emplace_back(parse_chunk, i);
+                        }catch(...){
+                                for(auto&worker:workers)
+                                        worker.join();
+                                throw;
+                        }
+                        parse_chunk(0);
+                        for(auto&worker:workers)
+                                worker.join();
+                        #else
+                        for(unsigned i=0; i<n; ++i)
+                                parse_chunk(i);
+                        #endif
+
+                        unsigned lines_before = in.get_file_line();
+                        for(unsigned i=0; i<n; ++i){
+                                if(chunk_error[i]){
+                                        try{
+                                                std::rethrow_exception(chunk_error[i]);
+                                        }catch(error::with_file_line&err){
+                                                err.set_file_line(err.file_line + lines_before);
+                                                throw;
+                                        }
+                                }
+                                lines_before += line_count[i];
+                        }
+                        in.set_file_line(lines_before);
+
+                        return rows;
+                }
+
+                // Same as read_chunks but concatenates the chunks.
+                template<class T, class RowReader>
+                std::vector<T> read_all(RowReader read_one){
+                        std::vector<std::vector<T>>chunks = read_chunks<T>(read_one);
+                        std::size_t row_count = 0;
+                        for(auto&chunk:chunks)
+                                row_count += chunk.size();
+
+                        std::vector<T>rows = std::move(chunks[0]);
+                        rows.reserve(row_count);
+                        for(std::size_t i=1; i<chunks.size(); ++i){
+                                std::move(chunks[i].begin(), chunks[i].end(), std::back_inserter(rows));
+                                std::vector<T>().swap(chunks[i]);
+                        }
+                        return rows;
+                }
+        };
+
+        ////////////////////////////////////////////////////////////////////////////
+        //                               CSV Writer                               //
+        ////////////////////////////////////////////////////////////////////////////
+
+        namespace error{
+                struct can_not_write_file :
+                        base,
+                        with_file_name,
+                        with_errno{
+                        void format_error_message()const override{
+                                if(errno_value != 0)
+                                        std::snprintf(error_message_buffer, sizeof(error_message_buffer),
+                                                "Can not write file \"%s\" because \"%s\"."
+                                                , file_name, std::strerror(errno_value));
+                                else
+                                        std::snprintf(error_message_buffer, sizeof(error_message_buffer),
+                                                "Can not write file \"%s\"."
+                                                , file_name);
+                        }
+                };
+
+                struct line_break_in_field :
+                        base,
+                        with_file_name{
+                        void format_error_message()const override{
+                                std::snprintf(error_message_buffer, sizeof(error_message_buffer),
+                                        "A field written to file \"%s\" contains a line break, which can not be read back."
+                                        , file_name);
+                        }
+                };
+        }
+
+        class ByteSinkBase{
+        public:
+                virtual void write(const char*buffer, std::size_t size)=0;
+                virtual void flush(){}
+                virtual ~ByteSinkBase(){}
+        };
+
+        namespace detail{
+                class OwningStdIOByteSink : public ByteSinkBase{
+                public:
+                        explicit OwningStdIOByteSink(FILE*file):file(file){
+                                // The writer does the buffering
+                                std::setvbuf(file, 0, _IONBF, 0);
+                        }
+
+                        void write(const char*buffer, std::size_t size){
+                                if(std::fwrite(buffer, 1, size, file) != size){
+                                        error::can_not_write_file err;
+                                        err.set_errno(errno);
+                                        throw err;
+                                }
+                        }
+
+                        void flush(){
+                                if(std::fflush(file) != 0){
+                                        error::can_not_write_file err;
+                                        err.set_errno(errno);
+                                        throw err;
+                                }
+                        }
+
+                        ~OwningStdIOByteSink(){
+                                std::fclose(file);
+                        }
+
+                private:
+                        FILE*file;
+                };
+
+                class NonOwningOStreamByteSink : public ByteSinkBase{
+                public:
+                        explicit NonOwningOStreamByteSink(std::ostream&out):out(out){}
+
+                        void write(const char*buffer, std::size_t size){
+                                if(!out.write(buffer, static_cast<std::streamsize>(size)))
+                                        throw error::can_not_write_file();
+                        }
+
+                        void flush(){
+                                if(!out.flush())
+                                        throw error::can_not_write_file();
+                        }
+
+                private:
+                        std::ostream&out;
+                };
+        }
+
+        // Writes rows into a reusable buffer that goes to the sink when it is full.
+        // Integers and floating point numbers are formatted with std::to_chars,
+        // floating point numbers in the shortest form that reads back exactly.
+        // Strings are written as they are unless they contain the separator or
+        // '"', or start or end with a space or tab. Those are enclosed in '"' with
+        // '"' doubled, as io::double_quote_escape<sep, '"'> reads them back. The
+        // line based reader can not read line breaks within fields back at all,
+        // so strings containing '\n' or '\r' throw error::line_break_in_field.
+        //
+        //   io::CSVWriter out("BTCUSDT_1m.csv");
+        //   out.write_row("open_time", "open", "high", "low", "close", "volume");
+        //   out.write_row(candle.openTime, candle.open, candle.high, candle.low, candle.close, candle.volume);
+        //
+        // The destructor flushes but swallows errors, call close() to see them.
+        class CSVWriter{
+        private:
+                std::unique_ptr<ByteSinkBase>sink;
+                std::unique_ptr<char[]>buffer;
+                std::size_t buffer_len;
+                std::size_t buffer_pos;
+                char sep;
+
+                char file_name[error::max_file_name_length+1];
+
+                // enough for any integer or the shortest form of any long double
+                static const std::size_t max_number_len = 64;
+
+                static std::unique_ptr<ByteSinkBase> open_file(const char*file_name, bool append){
+                        FILE*file = std::fopen(file_name, append ? "ab" : "wb");
+                        if(file == 0){
+                                int x = errno;
+                                error::can_not_open_file err;
+                                err.set_errno(x);
+                                err.set_file_name(file_name);
+                                throw err;
+                        }
+                        return std::unique_ptr<ByteSinkBase>(new detail::OwningStdIOByteSink(file));
+                }
+
+                void init(std::unique_ptr<ByteSinkBase>arg_sink, std::size_t arg_buffer_len, char arg_sep){
+                        sink = std::move(arg_sink);
+                        buffer_len = std::max(arg_buffer_len, 2*max_number_len);
+                        buffer = std::unique_ptr<char[]>(new char[buffer_len]);
+                        buffer_pos = 0;
+                        sep = arg_sep;
+                }
+
+                void write_buffer(){
+                        try{
+                                sink->write(buffer.get(), buffer_pos);
+                        }catch(error::with_file_name&err){
+                                err.set_file_name(file_name);
+                                throw;
+                        }
+                        buffer_pos = 0;
+                }
+
+                char*reserve(std::size_t len){
+                        if(buffer_len - buffer_pos < len)
+                                write_buffer();
+                        return buffer.get() + buffer_pos;
+                }
+
+                void write_chars(const char*str, std::size_t len){
+                        if(len > buffer_len - buffer_pos){
+                                write_buffer();
+                                if(len > buffer_len){
+                                        try{
+                                                sink->write(str, len);
+                                        }catch(error::with_file_name&err){
+                                                err.set_file_name(file_name);
+                                                throw;
+                                        }
+                                        return;
+                                }
+                        }
+                        std::memcpy(buffer.get() + buffer_pos, str, len);
+                        buffer_pos += len;
+                }
+
+                template<class T>
+                void write_number(T value){
+                        char*out = reserve(max_number_len);
+                        buffer_pos = std::to_chars(out, out + max_number_len, value).ptr - buffer.get();
+                }
+
+                void write_char(char value){
+                        *reserve(1) = value;
+                        ++buffer_pos;
+                }
+
+                // Checked for all fields before a row is written, so that no
+                // partial row is left behind
+                void check_string(std::string_view value){
+                        if(value.find_first_of("\n\r") != std::string_view::npos){
+                                error::line_break_in_field err;
+                                err.set_file_name(file_name);
+                                throw err;
+                        }
+                }
+
+                template<class T>
+                void check_field(const T&){}
+
+                void check_field(char value){check_string(std::string_view(&value, 1));}
+                void check_field(const char*value){check_string(value);}
+                void check_field(const std::string&value){check_string(value);}
+                void check_field(std::string_view value){check_string(value);}
+
+                void write_string(std::string_view value){
+                        bool needs_quotes = !value.empty()
+                                && (value.front() == ' ' || value.front() == '\t' || value.back() == ' ' || value.back() == '\t');
+                        for(char c:value)
+                                needs_quotes = needs_quotes || c == sep || c == '"';
+                        if(!needs_quotes){
+                                write_chars(value.data(), value.size());
+                                return;
+                        }
+
+                        write_char('"');
+                        for(;;){
+                                std::size_t quote_pos = value.find('"');
+                                if(quote_pos == std::string_view::npos)
+                                        break;
+                                // the quote itself and another one
+                                write_chars(value.data(), quote_pos + 1);
+                                write_char('"');
+                                value.remove_prefix(quote_pos + 1);
+                        }
+                        write_chars(value.data(), value.size());
+                        write_char('"');
+                }
+
+                void write_field(char value){
+                        write_string(std::string_view(&value, 1));
+                }
+
+                void write_field(signed char value){write_number(value);}
+                void write_field(unsigned char value){write_number(value);}
+                void write_field(short value){write_number(value);}
+                void write_field(unsigned short value){write_number(value);}
+                void write_field(int value){write_number(value);}
+                void write_field(unsigned value){write_number(value);}
+                void write_field(long value){write_number(value);}
+                void write_field(unsigned long value){write_number(value);}
+                void write_field(long long value){write_number(value);}
+                void write_field(unsigned long long value){write_number(value);}
+                void write_field(float value){write_number(value);}
+                void write_field(double value){write_number(value);}
+                void write_field(long double value){write_number(value);}
+
+                void write_field(const char*value){
+                        write_string(value);
+                }
+
+                void write_field(const std::string&value){
+                        write_string(value);
+                }
+
+                void write_field(std::string_view value){
+                        write_string(value);
+                }
+
+        public:
+                CSVWriter() = delete;
+                CSVWriter(const CSVWriter&) = delete;
+                CSVWriter&operator=(const CSVWriter&) = delete;
+
+                // append == false truncates an existing file
+                explicit CSVWriter(const char*file_name, bool append = false, std::size_t buffer_len = 1<<20, char sep = ','){
+                        set_file_name(file_name);
+                        init(open_file(file_name, append), buffer_len, sep);
+                }
+
+                explicit CSVWriter(const std::string&file_name, bool append = false, std::size_t buffer_len = 1<<20, char sep = ','){
+                        set_file_name(file_name.c_str());
+                        init(open_file(file_name.c_str(), append), buffer_len, sep);
+                }
+
+                CSVWriter(const char*file_name, std::unique_ptr<ByteSinkBase>sink, std::size_t buffer_len = 1<<20, char sep = ','){
+                        set_file_name(file_name);
+                        init(std::move(sink), buffer_len, sep);
+                }
+
+                CSVWriter(const std::string&file_name, std::unique_ptr<ByteSinkBase>sink, std::size_t buffer_len = 1<<20, char sep = ','){
+                        set_file_name(file_name.c_str());
+                        init(std::move(sink), buffer_len, sep);
+                }
+
+                CSVWriter(const char*file_name, std::ostream&out, std::size_t buffer_len = 1<<20, char sep = ','){
+                        set_file_name(file_name);
+                        init(std::unique_ptr<ByteSinkBase>(new detail::NonOwningOStreamByteSink(out)), buffer_len, sep);
+                }
+
+                CSVWriter(const std::string&file_name, std::ostream&out, std::size_t buffer_len = 1<<20, char sep = ','){
+                        set_file_name(file_name.c_str());
+                        init(std::unique_ptr<ByteSinkBase>(new detail::NonOwningOStreamByteSink(out)), buffer_len, sep);
+                }
+
+                void set_file_name(const std::string&file_name){
+                        set_file_name(file_name.c_str());
+                }
+
+                void set_file_name(const char*file_name){
+                        if(file_name != nullptr){
+                                // This call to strncpy has parenthesis around it
+                                // to silence the GCC -Wstringop-truncation warning
+                                (strncpy(this->file_name, file_name, sizeof(this->file_name)));
+                                this->file_name[sizeof(this->file_name)-1] = '\0';
+                        }else{
+                                this->file_name[0] = '\0';
+                        }
+                }
+
+                const char*get_truncated_file_name()const{
+                        return file_name;
+                }
+
+                template<class ...ColType>
+                void write_row(const ColType&...cols){
+                        static_assert(sizeof...(ColType) > 0, "no columns specified");
+                        (check_field(cols), ...);
+                        bool is_first = true;
+                        ((is_first ? void(is_first = false) : write_char(sep), write_field(cols)), ...);
+                        write_char('\n');
+                }
+
+                // Hands the buffered rows to the sink and flushes the sink
+                void flush(){
+                        write_buffer();
+                        try{
+                                sink->flush();
+                        }catch(error::with_file_name&err){
+                                err.set_file_name(file_name);
+                                throw;
+                        }
+                }
+
+                // Flushes and releases the sink, no rows can be written afterwards
+                void close(){
+                        if(sink != nullptr){
+                                flush();
+                                sink.reset();
+                        }
+                }
+
+                ~CSVWriter(){
+                        try{
+                                close();
+                        }catch(...){
+                        }
+                }
+        };
+
+        ////////////////////////////////////////////////////////////////////////////
+        //                               Time Index                               //
+        ////////////////////////////////////////////////////////////////////////////
+
+        namespace detail{
+                inline bool stat_file(const std::string&file_name, std::uint64_t&size, std::int64_t&mtime, std::error_code&ec){
+                        size = std::filesystem::file_size(file_name, ec);
+                        if(ec)
+                                return false;
+                        auto time = std::filesystem::last_write_time(file_name, ec);
+                        if(ec)
+                                return false;
+                        mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+                        return true;
+                }
+
+                // The index file holds the magic, the header fields and the entries,
+                // all little endian, so that it can be shared between machines.
+                static const char time_index_magic[8] = {'C', 'S', 'V', 'T', 'I', 'D', 'X', '1'};
+
+                template<class T>
+                void append_bytes(std::string&out, T x){
+                        static_assert(std::is_integral<T>::value, "only integers are stored");
+                        auto u = static_cast<typename std::make_unsigned<T>::type>(x);
+                        for(std::size_t i = 0; i < sizeof(T); ++i)
+                                out += static_cast<char>((u >> 8*i) & 0xFF);
+                }
+
+                template<class T>
+                bool take_bytes(const char*&in, const char*end, T&x){
+                        static_assert(std::is_integral<T>::value, "only integers are stored");
+                        if(static_cast<std::size_t>(end - in) < sizeof(x))
+                                return false;
+                        typename std::make_unsigned<T>::type u = 0;
+                        for(std::size_t i = 0; i < sizeof(T); ++i)
+                                u |= static_cast<decltype(u)>(static_cast<unsigned char>(in[i])) << 8*i;
+                        x = static_cast<T>(u);
+                        in += sizeof(x);
+                        return true;
+                }
+
+                inline void stat_file_or_throw(const std::string&file_name, std::uint64_t&size, std::int64_t&mtime){
+                        std::error_code ec;
+                        if(!stat_file(file_name, size, mtime, ec)){
+                                error::can_not_open_file err;
+                                err.set_errno(ec.value());
+                                err.set_file_name(file_name.c_str());
+                                throw err;
+                        }
+                }
+
+                // Adds the entries of the rows from the one of the last entry of index
+                // on, or of all rows if index has no entries. Returns false without
+                // touching index if that row is no longer where the index puts it.
+                template<class trim_policy, class quote_policy, class comment_policy>
+                bool scan_time_index(const std::string&file_name, time_index&index){
+                        CSVReader<1, trim_policy, quote_policy, throw_on_overflow, comment_policy>in(file_name);
+                        in.read_header(ignore_extra_column, index.column_name);
+
+                        std::vector<time_index::entry>entries;
+                        std::int64_t last_bucket = 0;
+                        if(!index.entries.empty()){
+                                const time_index::entry&last = index.entries.back();
+                                try{
+                                        std::int64_t timestamp;
+                                        if(!in.seek_to_timestamp(index, last.timestamp)
+                                                || in.get_file_line() != last.file_line + 1
+                                                || !in.read_row(as_timestamp_ms(timestamp))
+                                                || timestamp != last.timestamp)
+                                                return false;
+                                }catch(error::base&){
+                                        return false;
+                                }
+                                last_bucket = last.timestamp / index.bucket_ms - (last.timestamp % index.bucket_ms < 0);
+                        }
+
+                        for(;;){
+                                std::uint64_t offset = in.get_offset();
+                                unsigned file_line = in.get_file_line();
+                                std::int64_t timestamp;
+                                if(!in.read_row(as_timestamp_ms(timestamp)))
+                                        break;
+                                std::int64_t bucket = timestamp / index.bucket_ms - (timestamp % index.bucket_ms < 0);
+                                if((index.entries.empty() && entries.empty()) || bucket > last_bucket){
+                                        entries.push_back(time_index::entry{timestamp, offset, file_line});
+                                        last_bucket = bucket;
+                                }
+                        }
+                        index.entries.insert(index.entries.end(), entries.begin(), entries.end());
+                        return true;
+                }
+        }
+
+        // Name of the index file that belongs to file_name
+        inline std::string time_index_file_name(const std::string&file_name){
+                return file_name + ".idx";
+        }
+
+        // Indexes the CSV file by its timestamp column column_name, which is read
+        // as by io::as_timestamp_ms. Rows have to be sorted by that column.
+        template<class trim_policy = trim_chars<' ', '\t'>,
+                class quote_policy = no_quote_escape<','>,
+                class comment_policy = no_comment
+        >
+        time_index build_time_index(const std::string&file_name, const std::string&column_name, std::int64_t bucket_ms = 24*60*60*1000){
+                assert(bucket_ms > 0);
+
+                time_index index;
+                index.column_name = column_name;
+                index.bucket_ms = bucket_ms;
+                // taken before reading, so that a change while reading makes the index stale
+                detail::stat_file_or_throw(file_name, index.file_size, index.file_mtime);
+                detail::scan_time_index<trim_policy, quote_policy, comment_policy>(file_name, index);
+                return index;
+        }
+
+        inline void write_time_index(const std::string&index_file_name, const time_index&index){
+                std::string out(detail::time_index_magic, sizeof(detail::time_index_magic));
+                detail::append_bytes(out, index.bucket_ms);
+                detail::append_bytes(out, index.file_size);
+                detail::append_bytes(out, index.file_mtime);
+                detail::append_bytes(out, static_cast<std::uint32_t>(index.column_name.size()));
+                out += index.column_name;
+                detail::append_bytes(out, static_cast<std::uint64_t>(index.entries.size()));
+                for(const time_index::entry&e : index.entries){
+                        detail::append_bytes(out, e.timestamp);
+                        detail::append_bytes(out, e.offset);
+                        detail::append_bytes(out, static_cast<std::uint32_t>(e.file_line));
+                }
+
+                FILE*file = std::fopen(index_file_name.c_str(), "wb");
+                if(file == 0){
+                        int x = errno;
+                        error::can_not_open_file err;
+                        err.set_errno(x);
+                        err.set_file_name(index_file_name.c_str());
+                        throw err;
+                }
+                bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+                ok = std::fclose(file) == 0 && ok;
+                if(!ok){
+                        int x = errno;
+                        error::can_not_write_file err;
+                        err.set_errno(x);
+                        err.set_file_name(index_file_name.c_str());
+                        throw err;
+                }
+        }
+
+        namespace detail{
+                // Loads index_file_name without comparing it to the indexed file.
+                // Returns false if the index file is missing or malformed.
+                inline bool load_time_index(const std::string&index_file_name, time_index&index){
+                        std::string data;
+                        {
+                                FILE*file = std::fopen(index_file_name.c_str(), "rb");
+                                if(file == 0)
+                                        return false;
+                                char buffer[1<<16];
+                                std::size_t n;
+                                while((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+                                        data.append(buffer, n);
+                                bool ok = !std::ferror(file);
+                                std::fclose(file);
+                                if(!ok)
+                                        return false;
+                        }
+
+                        const char*in = data.data();
+                        const char*end = in + data.size();
+                        if(data.size() < sizeof(time_index_magic)
+                                || std::memcmp(in, time_index_magic, sizeof(time_index_magic)) != 0)
+                                return false;
+                        in += sizeof(time_index_magic);
+
+                        time_index result;
+                        std::uint32_t name_len;
+                        std::uint64_t entry_count;
+                        if(!take_bytes(in, end, result.bucket_ms)
+                                || !take_bytes(in, end, result.file_size)
+                                || !take_bytes(in, end, result.file_mtime)
+                                || !take_bytes(in, end, name_len)
+                                || static_cast<std::size_t>(end - in) < name_len)
+                                return false;
+                        result.column_name.assign(in, name_len);
+                        in += name_len;
+                        if(!take_bytes(in, end, entry_count)
+                                || entry_count != static_cast<std::uint64_t>(end - in) / 20
+                                || static_cast<std::uint64_t>(end - in) % 20 != 0)
+                                return false;
+
+                        result.entries.resize(entry_count);
+                        for(time_index::entry&e : result.entries){
+                                std::uint32_t file_line = 0;
+                                take_bytes(in, end, e.timestamp);
+                                take_bytes(in, end, e.offset);
+                                take_bytes(in, end, file_line);
+                                e.file_line = file_line;
+                        }
+                        index = std::move(result);
+                        return true;
+                }
+        }
+
+        // Loads the index of file_name from index_file_name. Returns false if the
+        // index file is missing or malformed, or if file_name changed since the
+        // index was built.
+        inline bool read_time_index(const std::string&index_file_name, const std::string&file_name, time_index&index){
+                time_index result;
+                if(!detail::load_time_index(index_file_name, result))
+                        return false;
+                std::uint64_t file_size;
+                std::int64_t file_mtime;
+                std::error_code ec;
+                if(!detail::stat_file(file_name, file_size, file_mtime, ec)
+                        || file_size != result.file_size || file_mtime != result.file_mtime)
+                        return false;
+                index = std::move(result);
+                return true;
+        }
+
+        // Loads the index next to file_name, or builds and stores it if it is
+        // missing, stale or for another column or bucket width. If file_name
+        // only grew and the row of the last entry is still in its place, the
+        // rows from there on are scanned and their entries appended; if the file
+        // shrank or that row moved, the index is rebuilt from scratch.
+        template<class trim_policy = trim_chars<' ', '\t'>,
+                class quote_policy = no_quote_escape<','>,
+                class comment_policy = no_comment
+        >
+        time_index update_time_index(const std::string&file_name, const std::string&column_name, std::int64_t bucket_ms = 24*60*60*1000){
+                time_index index;
+                std::string index_file_name = time_index_file_name(file_name);
+                std::uint64_t file_size;
+                std::int64_t file_mtime;
+                detail::stat_file_or_throw(file_name, file_size, file_mtime);
+                if(detail::load_time_index(index_file_name, index)
+                        && index.column_name == column_name && index.bucket_ms == bucket_ms){
+                        if(index.file_size == file_size && index.file_mtime == file_mtime)
+                                return index;
+                        if(index.file_size <= file_size){
+                                index.file_size = file_size;
+                                index.file_mtime = file_mtime;
+                                if(detail::scan_time_index<trim_policy, quote_policy, comment_policy>(file_name, index)){
+                                        write_time_index(index_file_name, index);
+                                        return index;
+                                }
+                        }
+                }
+                index = build_time_index<trim_policy, quote_policy, comment_policy>(file_name, column_name, bucket_ms);
+                write_time_index(index_file_name, index);
+                return index;
+        }
 }
 #endif
 
@@ -47,7 +47,8 @@ enum class MarketCategory : std::int32_t {
 };
 
 /**
- * Candle Interval, values are in seconds
+ * Candle Interval, values are in seconds. _1M is a nominal 30 days, see vk/utils/interval_utils.h for calendar
+ * months and ISO weeks
  */
 enum class CandleInterval : std::int32_t {
     _1m = 60,
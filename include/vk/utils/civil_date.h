@@ -0,0 +1,64 @@
+/**
+Civil Date Utilities
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_CIVIL_DATE_H
+#define INCLUDE_VK_UTILS_CIVIL_DATE_H
+
+#include <cstdint>
+
+namespace vk {
+/**
+ * Days from 1970-01-01 of a proleptic Gregorian date, H. Hinnant's days_from_civil (as used by date.h)
+ * written without branches, so that loops over it vectorize
+ * @param year
+ * @param month 1..12
+ * @param day 1..31, days past the end of the month carry over into the next one
+ * @return days from epoch, negative before 1970
+ */
+constexpr std::int64_t daysFromCivil(const int year, const int month, const int day) {
+    const int y = year - (month <= 2);
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<std::int64_t>(era) * 146097 + doe - 719468;
+}
+
+/**
+ * Proleptic Gregorian date of days from 1970-01-01, inverse of daysFromCivil (H. Hinnant's civil_from_days)
+ * @param days days from epoch
+ * @param year
+ * @param month 1..12
+ * @param day 1..31
+ */
+constexpr void civilFromDays(const std::int64_t days, int& year, int& month, int& day) {
+    const std::int64_t z = days + 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int doe = static_cast<int>(z - era * 146097);
+    const int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int>(yoe + era * 400) + (month <= 2);
+}
+
+/**
+ * @param year
+ * @param month 1..12
+ * @return number of days of the month of the proleptic Gregorian calendar
+ */
+constexpr int daysInMonth(const int year, const int month) {
+    if (month == 2) {
+        return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0) ? 29 : 28;
+    }
+
+    return month == 4 || month == 6 || month == 9 || month == 11 ? 30 : 31;
+}
+}
+#endif // INCLUDE_VK_UTILS_CIVIL_DATE_H
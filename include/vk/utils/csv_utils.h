@@ -0,0 +1,65 @@
+/**
+CSV Utilities
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_CSV_UTILS_H
+#define INCLUDE_VK_UTILS_CSV_UTILS_H
+
+#include "csv.h"
+#include "vk/interface/exchange_types.h"
+
+namespace vk {
+/**
+ * Write CSV header for the given row type, columns match writeCsvRow
+ * @tparam Row Candle or FundingRate
+ * @param writer
+ */
+template <typename Row>
+void writeCsvHeader(io::CSVWriter& writer);
+
+template <>
+inline void writeCsvHeader<Candle>(io::CSVWriter& writer) {
+    writer.write_row("open_time", "open", "high", "low", "close", "volume");
+}
+
+template <>
+inline void writeCsvHeader<FundingRate>(io::CSVWriter& writer) {
+    writer.write_row("symbol", "funding_rate", "funding_time");
+}
+
+/**
+ * Write Candle as CSV row: open_time,open,high,low,close,volume
+ * @param writer
+ * @param candle
+ */
+inline void writeCsvRow(io::CSVWriter& writer, const Candle& candle) {
+    writer.write_row(candle.openTime, candle.open, candle.high, candle.low, candle.close, candle.volume);
+}
+
+/**
+ * Write FundingRate as CSV row: symbol,funding_rate,funding_time, customData is not written
+ * @param writer
+ * @param fundingRate
+ */
+inline void writeCsvRow(io::CSVWriter& writer, const FundingRate& fundingRate) {
+    writer.write_row(fundingRate.symbol, fundingRate.fundingRate, fundingRate.fundingTime);
+}
+
+/**
+ * Write all rows
+ * @param writer
+ * @param rows vector of Candle or FundingRate
+ */
+template <typename Row>
+void writeCsvRows(io::CSVWriter& writer, const std::vector<Row>& rows) {
+    for (const auto& row : rows) {
+        writeCsvRow(writer, row);
+    }
+}
+}
+
+#endif //INCLUDE_VK_UTILS_CSV_UTILS_H
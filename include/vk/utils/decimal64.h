@@ -0,0 +1,728 @@
+/**
+Fixed-point Decimal
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_DECIMAL64_H
+#define INCLUDE_VK_UTILS_DECIMAL64_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace vk {
+/**
+ * How Decimal64 rounds the digits it can not keep
+ */
+enum class RoundingMode : std::int32_t {
+    Down = 0,       ///< towards zero, e.g. order quantities
+    Up = 1,         ///< away from zero
+    Floor = 2,      ///< towards -infinity, e.g. buy prices
+    Ceiling = 3,    ///< towards +infinity, e.g. sell prices
+    HalfUp = 4,     ///< to the nearest, ties away from zero
+    HalfEven = 5    ///< to the nearest, ties to the even neighbour
+};
+
+/**
+ * Decimal number stored as a 64-bit integer mantissa and a number of decimal places (scale),
+ * value = mantissa / 10^scale. Meant for prices and quantities in the precision of their symbol, e.g. scale 2 for
+ * a 0.01 tick size. Exact like boost::multiprecision::cpp_dec_float_50, but it is two integers, never allocates and
+ * most of the operations are a few integer instructions.
+ *
+ * Parsing and formatting are exact. Sums keep the larger scale of the operands, products the sum of the scales
+ * (at most MAX_SCALE), division and rescaling to fewer decimal places round by a RoundingMode. Results out of the range
+ * of the mantissa throw std::overflow_error. Values with different scales compare by value, so 1.5 == 1.50,
+ * and the ordering is weak as they still differ in scale and formatting.
+ */
+class Decimal64 {
+public:
+    static constexpr int MAX_SCALE = 18;
+
+    /// "-" + 19 digits + ".", or "-0." + 18 digits
+    static constexpr std::size_t MAX_STRING_SIZE = 21;
+
+    using StringBuffer = std::array<char, MAX_STRING_SIZE>;
+
+    constexpr Decimal64() noexcept = default;
+
+    /**
+     * @param mantissa
+     * @param scale number of decimal places, Decimal64(12345, 2) is 123.45
+     * @throws std::invalid_argument if scale is not in 0..MAX_SCALE
+     */
+    constexpr Decimal64(const std::int64_t mantissa, const int scale) : m_mantissa(mantissa),
+                                                                       m_scale(checkScale(scale)) {}
+
+    /**
+     * @param s see parse(std::string_view)
+     * @throws std::invalid_argument if s is not a number or can not be represented exactly
+     */
+    explicit Decimal64(const std::string_view s) {
+        const auto value = parse(s);
+
+        if (!value) {
+            throw std::invalid_argument("Invalid Decimal64 value: " + std::string(s));
+        }
+
+        *this = *value;
+    }
+
+    /**
+     * Parse the exact value of s, the scale is the number of decimal places written, so "0.0100" has scale 4.
+     * Takes an optional sign, digits with an optional decimal point and an optional exponent ("1e-8", "2.5E3"),
+     * nothing else, not even white space.
+     * @param s
+     * @return std::nullopt if s is not a number, is out of range or has non-zero digits beyond MAX_SCALE places
+     */
+    static constexpr std::optional<Decimal64> parse(const std::string_view s) noexcept {
+        return parse(s, -1, RoundingMode::Down, true);
+    }
+
+    /**
+     * Parse s into the given scale, e.g. the precision of the symbol, rounding the digits beyond it
+     * @param s see parse(std::string_view)
+     * @param scale
+     * @param mode
+     * @return std::nullopt if s is not a number, is out of range or the scale is not in 0..MAX_SCALE
+     */
+    static constexpr std::optional<Decimal64> parse(const std::string_view s, const int scale,
+                                                    const RoundingMode mode = RoundingMode::HalfEven) noexcept {
+        if (scale < 0 || scale > MAX_SCALE) {
+            return std::nullopt;
+        }
+
+        return parse(s, scale, mode, false);
+    }
+
+    /**
+     * The shortest decimal reading back as value, the way JSON serializers write doubles, so 0.1 becomes 0.1 and not
+     * 0.1000000000000000055511151231257827
+     * @param value
+     * @return std::nullopt for NaN, infinities, values out of range or with more than MAX_SCALE decimal places
+     */
+    static std::optional<Decimal64> fromDouble(const double value) noexcept {
+        std::array<char, 32> buffer{};
+        const auto [ptr, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+        return ec == std::errc() ? parse(std::string_view(buffer.data(), ptr - buffer.data())) : std::nullopt;
+    }
+
+    /**
+     * The shortest decimal reading back as value rounded to the given scale
+     * @param value
+     * @param scale
+     * @param mode
+     * @return std::nullopt for NaN, infinities, values out of range or if the scale is not in 0..MAX_SCALE
+     */
+    static std::optional<Decimal64> fromDouble(const double value, const int scale,
+                                               const RoundingMode mode = RoundingMode::HalfEven) noexcept {
+        std::array<char, 32> buffer{};
+        const auto [ptr, ec] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+        return ec == std::errc() ? parse(std::string_view(buffer.data(), ptr - buffer.data()), scale, mode)
+                                 : std::nullopt;
+    }
+
+    [[nodiscard]] constexpr std::int64_t mantissa() const noexcept {
+        return m_mantissa;
+    }
+
+    [[nodiscard]] constexpr int scale() const noexcept {
+        return m_scale;
+    }
+
+    /**
+     * @return exact for mantissas up to 2^53, otherwise within one ulp
+     */
+    [[nodiscard]] constexpr double toDouble() const noexcept {
+        return static_cast<double>(m_mantissa) / static_cast<double>(POW10[m_scale]);
+    }
+
+    /**
+     * @param scale
+     * @param mode used when scale is smaller than the current one
+     * @return the value with scale decimal places
+     * @throws std::invalid_argument if scale is not in 0..MAX_SCALE
+     * @throws std::overflow_error
+     */
+    [[nodiscard]] constexpr Decimal64 rescaled(const int scale,
+                                               const RoundingMode mode = RoundingMode::HalfEven) const {
+        checkScale(scale);
+
+        if (scale >= m_scale) {
+            return {checked(scaleUp(m_mantissa, scale - m_scale)), scale};
+        }
+
+        Uint128 value{0, magnitude(m_mantissa)};
+        return {divideByPow10(value, m_scale - scale, m_mantissa < 0, mode), scale};
+    }
+
+    /**
+     * @return the same value without trailing zero decimal places, e.g. 1.5 for 1.500
+     */
+    [[nodiscard]] constexpr Decimal64 normalized() const noexcept {
+        Decimal64 retVal = *this;
+
+        while (retVal.m_scale > 0 && retVal.m_mantissa % 10 == 0) {
+            retVal.m_mantissa /= 10;
+            --retVal.m_scale;
+        }
+
+        return retVal;
+    }
+
+    /**
+     * Round to a multiple of the tick size (or the lot step), e.g. RoundingMode::Floor for the price of a buy order
+     * @param tick
+     * @param mode
+     * @return the multiple of tick with the scale of tick
+     * @throws std::invalid_argument if tick is not positive
+     * @throws std::overflow_error
+     */
+    [[nodiscard]] constexpr Decimal64 roundToTick(const Decimal64& tick, const RoundingMode mode) const {
+        if (tick.m_mantissa <= 0) {
+            throw std::invalid_argument("Decimal64 tick size must be positive");
+        }
+
+        const int scale = std::max(m_scale, tick.m_scale);
+        const bool negative = m_mantissa < 0;
+        Uint128 ticks = multiplyWide(magnitude(m_mantissa), POW10[scale - m_scale]);
+        const Uint128 step = multiplyWide(static_cast<std::uint64_t>(tick.m_mantissa), POW10[scale - tick.m_scale]);
+        bool away;
+
+        // Only the tick was scaled up, 2 * value <= 2^64 <= step
+        if (step.high != 0) {
+            away = roundsAway(mode, negative, false, ticks.low != 0, -1);
+            ticks = {};
+        }
+        else {
+            const std::uint64_t remainder = divideWide(ticks, step.low);
+            away = roundsAway(mode, negative, ticks.low % 2 != 0, remainder != 0, compareToHalf(remainder, step.low));
+        }
+
+        if (ticks.high != 0 || ticks.low == UINT64_MAX) {
+            throw std::overflow_error("Decimal64 overflow");
+        }
+
+        const Uint128 retVal = multiplyWide(ticks.low + away, static_cast<std::uint64_t>(tick.m_mantissa));
+        return {checked(toMantissa(retVal, negative, false)), tick.m_scale};
+    }
+
+    /**
+     * @param other
+     * @param scale of the result, e.g. of the quote currency for price * quantity
+     * @param mode used when scale is smaller than the sum of the scales
+     * @return
+     * @throws std::invalid_argument if scale is not in 0..MAX_SCALE
+     * @throws std::overflow_error
+     */
+    [[nodiscard]] constexpr Decimal64 multiply(const Decimal64& other, const int scale,
+                                               const RoundingMode mode = RoundingMode::HalfEven) const {
+        checkScale(scale);
+        const bool negative = (m_mantissa < 0) != (other.m_mantissa < 0);
+        Uint128 product = multiplyWide(magnitude(m_mantissa), magnitude(other.m_mantissa));
+
+        if (const int productScale = m_scale + other.m_scale; scale < productScale) {
+            return {divideByPow10(product, productScale - scale, negative, mode), scale};
+        }
+        else if (!multiplyWide(product, POW10[scale - productScale])) {
+            throw std::overflow_error("Decimal64 overflow");
+        }
+
+        return {checked(toMantissa(product, negative, false)), scale};
+    }
+
+    /**
+     * There is no operator/, a quotient needs a scale, e.g. quantity = notional.divide(price, lotScale, Down)
+     * @param other
+     * @param scale of the result
+     * @param mode
+     * @return
+     * @throws std::invalid_argument if scale is not in 0..MAX_SCALE
+     * @throws std::domain_error if other is zero
+     * @throws std::overflow_error
+     */
+    [[nodiscard]] constexpr Decimal64 divide(const Decimal64& other, const int scale,
+                                             const RoundingMode mode = RoundingMode::HalfEven) const {
+        checkScale(scale);
+
+        if (other.m_mantissa == 0) {
+            throw std::domain_error("Decimal64 division by zero");
+        }
+
+        const bool negative = (m_mantissa < 0) != (other.m_mantissa < 0);
+        // |this| * 10^(scale - m_scale) / (|other| * 10^-other.m_scale)
+        const int exponent = scale + other.m_scale - m_scale;
+        Uint128 numerator{0, magnitude(m_mantissa)};
+        Uint128 denominator{0, magnitude(other.m_mantissa)};
+
+        for (int i = exponent; i > 0; i -= MAX_SCALE) {
+            if (!multiplyWide(numerator, POW10[std::min(i, MAX_SCALE)])) {
+                throw std::overflow_error("Decimal64 overflow");
+            }
+        }
+
+        if (exponent < 0) {
+            multiplyWide(denominator, POW10[-exponent]);
+        }
+
+        // 2 * numerator <= 2^64 <= denominator, the quotient is below one half
+        if (denominator.high != 0) {
+            const bool away = roundsAway(mode, negative, false, numerator.low != 0, -1);
+            return {checked(toMantissa({}, negative, away)), scale};
+        }
+
+        const std::uint64_t remainder = divideWide(numerator, denominator.low);
+        const bool away = roundsAway(mode, negative, numerator.low % 2 != 0, remainder != 0,
+                                     compareToHalf(remainder, denominator.low));
+        return {checked(toMantissa(numerator, negative, away)), scale};
+    }
+
+    /**
+     * Write all the scale decimal places, "1.50" for Decimal64(150, 2), see normalized()
+     * @param out
+     * @return a view of out
+     */
+    constexpr std::string_view toString(StringBuffer& out) const noexcept {
+        std::uint64_t value = magnitude(m_mantissa);
+        char* const end = out.data() + out.size();
+        char* begin = end;
+
+        for (int i = 0; i < m_scale; ++i) {
+            *--begin = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+
+        if (m_scale != 0) {
+            *--begin = '.';
+        }
+
+        do {
+            *--begin = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+
+        if (m_mantissa < 0) {
+            *--begin = '-';
+        }
+
+        return {begin, static_cast<std::size_t>(end - begin)};
+    }
+
+    [[nodiscard]] std::string toString() const {
+        StringBuffer buffer;
+        return std::string(toString(buffer));
+    }
+
+    constexpr Decimal64 operator-() const {
+        if (m_mantissa == std::numeric_limits<std::int64_t>::min()) {
+            throw std::overflow_error("Decimal64 overflow");
+        }
+
+        return {-m_mantissa, m_scale};
+    }
+
+    friend constexpr Decimal64 operator+(const Decimal64& lhs, const Decimal64& rhs) {
+        const int scale = std::max(lhs.m_scale, rhs.m_scale);
+        const std::int64_t a = checked(scaleUp(lhs.m_mantissa, scale - lhs.m_scale));
+        const std::int64_t b = checked(scaleUp(rhs.m_mantissa, scale - rhs.m_scale));
+
+        if (b > 0 ? a > std::numeric_limits<std::int64_t>::max() - b
+                  : a < std::numeric_limits<std::int64_t>::min() - b) {
+            throw std::overflow_error("Decimal64 overflow");
+        }
+
+        return {a + b, scale};
+    }
+
+    friend constexpr Decimal64 operator-(const Decimal64& lhs, const Decimal64& rhs) {
+        const int scale = std::max(lhs.m_scale, rhs.m_scale);
+        const std::int64_t a = checked(scaleUp(lhs.m_mantissa, scale - lhs.m_scale));
+        const std::int64_t b = checked(scaleUp(rhs.m_mantissa, scale - rhs.m_scale));
+
+        if (b < 0 ? a > std::numeric_limits<std::int64_t>::max() + b
+                  : a < std::numeric_limits<std::int64_t>::min() + b) {
+            throw std::overflow_error("Decimal64 overflow");
+        }
+
+        return {a - b, scale};
+    }
+
+    /**
+     * Exact product, rounded by RoundingMode::HalfEven only when the sum of the scales exceeds MAX_SCALE
+     */
+    friend constexpr Decimal64 operator*(const Decimal64& lhs, const Decimal64& rhs) {
+        return lhs.multiply(rhs, std::min(lhs.m_scale + rhs.m_scale, MAX_SCALE));
+    }
+
+    constexpr Decimal64& operator+=(const Decimal64& other) {
+        return *this = *this + other;
+    }
+
+    constexpr Decimal64& operator-=(const Decimal64& other) {
+        return *this = *this - other;
+    }
+
+    constexpr Decimal64& operator*=(const Decimal64& other) {
+        return *this = *this * other;
+    }
+
+    friend constexpr std::weak_ordering operator<=>(const Decimal64& lhs, const Decimal64& rhs) noexcept {
+        if (lhs.m_scale == rhs.m_scale) {
+            return lhs.m_mantissa <=> rhs.m_mantissa;
+        }
+
+        // Integer parts first, the fractional parts aligned to the larger scale always fit then
+        const auto lhsUnit = static_cast<std::int64_t>(POW10[lhs.m_scale]);
+        const auto rhsUnit = static_cast<std::int64_t>(POW10[rhs.m_scale]);
+
+        if (const auto retVal = lhs.m_mantissa / lhsUnit <=> rhs.m_mantissa / rhsUnit; retVal != 0) {
+            return retVal;
+        }
+
+        const int scale = std::max(lhs.m_scale, rhs.m_scale);
+        return lhs.m_mantissa % lhsUnit * static_cast<std::int64_t>(POW10[scale - lhs.m_scale]) <=>
+               rhs.m_mantissa % rhsUnit * static_cast<std::int64_t>(POW10[scale - rhs.m_scale]);
+    }
+
+    friend constexpr bool operator==(const Decimal64& lhs, const Decimal64& rhs) noexcept {
+        return (lhs <=> rhs) == 0;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Decimal64& value) {
+        StringBuffer buffer;
+        return os << value.toString(buffer);
+    }
+
+private:
+    struct Uint128 {
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+    };
+
+    static constexpr std::array<std::uint64_t, MAX_SCALE + 1> POW10 = [] {
+        std::array<std::uint64_t, MAX_SCALE + 1> retVal{};
+        retVal[0] = 1;
+
+        for (std::size_t i = 1; i < retVal.size(); ++i) {
+            retVal[i] = retVal[i - 1] * 10;
+        }
+
+        return retVal;
+    }();
+
+    /// Exponents are saturated here, any larger one overflows or drops all the digits anyway
+    static constexpr std::int64_t MAX_EXPONENT = 1'000'000'000'000'000;
+
+    static constexpr int checkScale(const int scale) {
+        if (scale < 0 || scale > MAX_SCALE) {
+            throw std::invalid_argument("Decimal64 scale out of range");
+        }
+
+        return scale;
+    }
+
+    static constexpr std::uint64_t magnitude(const std::int64_t value) noexcept {
+        return value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    }
+
+    static constexpr std::int64_t checked(const std::optional<std::int64_t> value) {
+        if (!value) {
+            throw std::overflow_error("Decimal64 overflow");
+        }
+
+        return *value;
+    }
+
+    /**
+     * @param value magnitude
+     * @param negative
+     * @param away add one to the magnitude
+     * @return std::nullopt if the result is out of the range of std::int64_t
+     */
+    static constexpr std::optional<std::int64_t> toMantissa(const Uint128 value, const bool negative,
+                                                            const bool away) noexcept {
+        const std::uint64_t limit = (std::uint64_t(1) << 63) - (negative ? 0 : 1);
+
+        if (value.high != 0 || value.low > limit - away) {
+            return std::nullopt;
+        }
+
+        const std::uint64_t retVal = value.low + away;
+        return static_cast<std::int64_t>(negative ? 0 - retVal : retVal);
+    }
+
+    static constexpr std::optional<std::int64_t> scaleUp(const std::int64_t mantissa, const int places) noexcept {
+        return toMantissa(multiplyWide(magnitude(mantissa), POW10[places]), mantissa < 0, false);
+    }
+
+    /**
+     * @param mode
+     * @param negative
+     * @param odd the last kept digit
+     * @param inexact some non-zero digits were dropped
+     * @param half the dropped part compared to one half of the last kept place, < 0, 0 or > 0
+     * @return true if the magnitude is to be rounded up
+     */
+    static constexpr bool roundsAway(const RoundingMode mode, const bool negative, const bool odd, const bool inexact,
+                                     const int half) noexcept {
+        if (!inexact) {
+            return false;
+        }
+
+        switch (mode) {
+            case RoundingMode::Down:
+                return false;
+            case RoundingMode::Up:
+                return true;
+            case RoundingMode::Floor:
+                return negative;
+            case RoundingMode::Ceiling:
+                return !negative;
+            case RoundingMode::HalfUp:
+                return half >= 0;
+            case RoundingMode::HalfEven:
+                return half > 0 || (half == 0 && odd);
+        }
+
+        return false;
+    }
+
+    /**
+     * @return remainder compared to divisor / 2
+     */
+    static constexpr int compareToHalf(const std::uint64_t remainder, const std::uint64_t divisor) noexcept {
+        return remainder < divisor - remainder ? -1 : remainder == divisor - remainder ? 0 : 1;
+    }
+
+    /**
+     * @param digit first dropped digit
+     * @param sticky any of the further dropped digits is non-zero
+     * @return
+     */
+    static constexpr int compareToHalf(const std::uint64_t digit, const bool sticky) noexcept {
+        return digit > 5 || (digit == 5 && sticky) ? 1 : digit == 5 ? 0 : -1;
+    }
+
+    static constexpr Uint128 multiplyWide(const std::uint64_t a, const std::uint64_t b) noexcept {
+#ifdef __SIZEOF_INT128__
+        const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        return {static_cast<std::uint64_t>(product >> 64), static_cast<std::uint64_t>(product)};
+#else
+        const std::uint64_t lowLow = (a & 0xffffffff) * (b & 0xffffffff);
+        const std::uint64_t lowHigh = (a & 0xffffffff) * (b >> 32);
+        const std::uint64_t highLow = (a >> 32) * (b & 0xffffffff);
+        const std::uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffff) + (highLow & 0xffffffff);
+        return {(a >> 32) * (b >> 32) + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32),
+                middle << 32 | (lowLow & 0xffffffff)};
+#endif
+    }
+
+    /**
+     * @return false if the product does not fit in 128 bits
+     */
+    static constexpr bool multiplyWide(Uint128& value, const std::uint64_t factor) noexcept {
+        const Uint128 low = multiplyWide(value.low, factor);
+        const Uint128 high = multiplyWide(value.high, factor);
+
+        if (high.high != 0 || low.high + high.low < low.high) {
+            return false;
+        }
+
+        value = {low.high + high.low, low.low};
+        return true;
+    }
+
+    /**
+     * @param value replaced by the quotient
+     * @param divisor
+     * @return remainder
+     */
+    static constexpr std::uint64_t divideWide(Uint128& value, const std::uint64_t divisor) noexcept {
+#ifdef __SIZEOF_INT128__
+        const unsigned __int128 dividend = static_cast<unsigned __int128>(value.high) << 64 | value.low;
+        const unsigned __int128 quotient = dividend / divisor;
+        value = {static_cast<std::uint64_t>(quotient >> 64), static_cast<std::uint64_t>(quotient)};
+        return static_cast<std::uint64_t>(dividend - quotient * divisor);
+#else
+        // Shift and subtract, MSVC has no 128-bit integers
+        Uint128 quotient;
+        std::uint64_t remainder = 0;
+
+        for (int i = 127; i >= 0; --i) {
+            const bool carry = remainder >> 63 != 0;
+            remainder = remainder << 1 | ((i >= 64 ? value.high >> (i - 64) : value.low >> i) & 1);
+
+            if (carry || remainder >= divisor) {
+                remainder -= divisor;
+                (i >= 64 ? quotient.high : quotient.low) |= std::uint64_t(1) << (i % 64);
+            }
+        }
+
+        value = quotient;
+        return remainder;
+#endif
+    }
+
+    /**
+     * @param value magnitude
+     * @param places > 0
+     * @param negative
+     * @param mode
+     * @return value / 10^places rounded by mode
+     * @throws std::overflow_error
+     */
+    static constexpr std::int64_t divideByPow10(Uint128& value, const int places, const bool negative,
+                                                const RoundingMode mode) {
+        bool sticky = false;
+
+        for (int i = places - 1; i > 0; i -= MAX_SCALE) {
+            sticky = divideWide(value, POW10[std::min(i, MAX_SCALE)]) != 0 || sticky;
+        }
+
+        const std::uint64_t digit = divideWide(value, 10);
+        return checked(toMantissa(value, negative, roundsAway(mode, negative, value.low % 2 != 0, digit != 0 || sticky,
+                                                              compareToHalf(digit, sticky))));
+    }
+
+    static constexpr bool isDigit(const char c) noexcept {
+        return c >= '0' && c <= '9';
+    }
+
+    /**
+     * @param s
+     * @param scale ignored when exact
+     * @param mode ignored when exact
+     * @param exact scale is the number of decimal places of s up to MAX_SCALE, fail instead of rounding
+     * @return
+     */
+    static constexpr std::optional<Decimal64> parse(const std::string_view s, int scale, const RoundingMode mode,
+                                                    const bool exact) noexcept {
+        std::size_t pos = 0;
+        const bool negative = !s.empty() && s[0] == '-';
+
+        if (!s.empty() && (s[0] == '-' || s[0] == '+')) {
+            ++pos;
+        }
+
+        const std::size_t intBegin = pos;
+
+        while (pos < s.size() && isDigit(s[pos])) {
+            ++pos;
+        }
+
+        const std::size_t intSize = pos - intBegin;
+        std::size_t fracBegin = pos;
+
+        if (pos < s.size() && s[pos] == '.') {
+            fracBegin = ++pos;
+
+            while (pos < s.size() && isDigit(s[pos])) {
+                ++pos;
+            }
+        }
+
+        const std::size_t fracSize = pos - fracBegin;
+
+        if (intSize + fracSize == 0) {
+            return std::nullopt;
+        }
+
+        std::int64_t exponent = 0;
+
+        if (pos < s.size() && (s[pos] == 'e' || s[pos] == 'E')) {
+            const bool negativeExponent = ++pos < s.size() && s[pos] == '-';
+
+            if (pos < s.size() && (s[pos] == '-' || s[pos] == '+')) {
+                ++pos;
+            }
+
+            const std::size_t expBegin = pos;
+
+            for (; pos < s.size() && isDigit(s[pos]); ++pos) {
+                exponent = std::min(exponent * 10 + (s[pos] - '0'), MAX_EXPONENT);
+            }
+
+            if (pos == expBegin) {
+                return std::nullopt;
+            }
+
+            exponent = negativeExponent ? -exponent : exponent;
+        }
+
+        if (pos != s.size()) {
+            return std::nullopt;
+        }
+
+        if (exact) {
+            scale = static_cast<int>(std::clamp<std::int64_t>(static_cast<std::int64_t>(fracSize) - exponent, 0,
+                                                              MAX_SCALE));
+        }
+
+        // Digits of the integer and the fractional part are kept up to the scale-th decimal place
+        const auto digits = static_cast<std::int64_t>(intSize + fracSize);
+        const std::int64_t kept = static_cast<std::int64_t>(intSize) + exponent + scale;
+        const std::uint64_t limit = (std::uint64_t(1) << 63) - (negative ? 0 : 1);
+        std::uint64_t value = 0;
+
+        const auto digitAt = [&](const std::int64_t i) {
+            const auto index = static_cast<std::size_t>(i);
+            const char c = index < intSize ? s[intBegin + index] : s[fracBegin + index - intSize];
+            return static_cast<std::uint64_t>(c - '0');
+        };
+
+        for (std::int64_t i = 0; i < std::min(kept, digits); ++i) {
+            const std::uint64_t digit = digitAt(i);
+
+            if (value > (limit - digit) / 10) {
+                return std::nullopt;
+            }
+
+            value = value * 10 + digit;
+        }
+
+        if (kept < digits) {
+            const std::uint64_t digit = kept >= 0 ? digitAt(kept) : 0;
+            bool sticky = false;
+
+            for (std::int64_t i = std::max<std::int64_t>(kept + 1, 0); i < digits && !sticky; ++i) {
+                sticky = digitAt(i) != 0;
+            }
+
+            if (exact && (digit != 0 || sticky)) {
+                return std::nullopt;
+            }
+
+            if (roundsAway(mode, negative, value % 2 != 0, digit != 0 || sticky, compareToHalf(digit, sticky))) {
+                if (value == limit) {
+                    return std::nullopt;
+                }
+
+                ++value;
+            }
+        }
+        else if (value != 0 && kept > digits) {
+            if (kept - digits > MAX_SCALE || value > limit / POW10[kept - digits]) {
+                return std::nullopt;
+            }
+
+            value *= POW10[kept - digits];
+        }
+
+        return Decimal64(static_cast<std::int64_t>(negative ? 0 - value : value), scale);
+    }
+
+    std::int64_t m_mantissa = 0;
+    int m_scale = 0;
+};
+}
+#endif // INCLUDE_VK_UTILS_DECIMAL64_H
@@ -0,0 +1,87 @@
+/**
+HMAC-SHA256 Signer
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_HMAC_SHA256_H
+#define INCLUDE_VK_UTILS_HMAC_SHA256_H
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+namespace vk {
+/**
+ * HMAC-SHA256 (RFC 2104) for signing exchange requests. The SHA-256 states after the inner and the outer key pad are
+ * computed once in the constructor, so signing a message costs only the blocks of the message plus one more block.
+ * Uses the SHA extensions (SHA-NI) when the CPU has them. A signer is immutable and can be shared between threads.
+ */
+class HmacSha256 {
+public:
+    static constexpr std::size_t DIGEST_SIZE = 32;
+
+    using Digest = std::array<std::uint8_t, DIGEST_SIZE>;
+    using HexBuffer = std::array<char, 2 * DIGEST_SIZE>;
+    using Base64Buffer = std::array<char, (DIGEST_SIZE + 2) / 3 * 4>;
+
+    /**
+     * @param secret API secret, secrets longer than 64 bytes are hashed first as the RFC says
+     */
+    explicit HmacSha256(std::string_view secret);
+
+    /**
+     * @param message e.g. query string
+     * @return
+     */
+    [[nodiscard]] Digest sign(std::string_view message) const;
+
+    /**
+     * Sign the concatenation of parts without building it, e.g. {timestamp, method, path, body}
+     * @param parts
+     * @return
+     */
+    [[nodiscard]] Digest sign(std::initializer_list<std::string_view> parts) const;
+
+    /**
+     * @param message
+     * @param out
+     * @return lower case hex of the signature, a view of out
+     */
+    std::string_view signHex(std::string_view message, HexBuffer& out) const;
+
+    /**
+     * @param message
+     * @param out
+     * @param url use the URL alphabet of base64_encode
+     * @return base64 of the signature, a view of out
+     */
+    std::string_view signBase64(std::string_view message, Base64Buffer& out, bool url = false) const;
+
+    /**
+     * @param message
+     * @return lower case hex of the signature
+     */
+    [[nodiscard]] std::string signHex(std::string_view message) const;
+
+    /**
+     * @param message
+     * @param url use the URL alphabet of base64_encode
+     * @return base64 of the signature
+     */
+    [[nodiscard]] std::string signBase64(std::string_view message, bool url = false) const;
+
+    static std::string_view toHex(const Digest& digest, HexBuffer& out);
+
+    static std::string_view toBase64(const Digest& digest, Base64Buffer& out, bool url = false);
+
+private:
+    std::array<std::uint32_t, 8> m_innerState{};
+    std::array<std::uint32_t, 8> m_outerState{};
+};
+}
+#endif // INCLUDE_VK_UTILS_HMAC_SHA256_H
@@ -0,0 +1,180 @@
+/**
+Candle Interval Utilities
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_INTERVAL_UTILS_H
+#define INCLUDE_VK_UTILS_INTERVAL_UTILS_H
+
+#include "vk/interface/exchange_enums.h"
+#include "vk/utils/utils.h"
+#include <span>
+#include <vector>
+
+/**
+ * Bucketing of ms timestamps into candles. Intervals up to 3d are aligned to the epoch, _1w to ISO weeks
+ * (Monday 00:00 UTC) and _1M to calendar months (1st 00:00 UTC), the nominal 2592000 s of _1M is not used.
+ * Candles are numbered by their index: the number of candles between the epoch and their open time.
+ */
+namespace vk {
+/**
+ * Floor division, rounds towards minus infinity
+ */
+constexpr std::int64_t floorDiv(const std::int64_t a, const std::int64_t b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+/// ISO weeks start on Monday, 1970-01-01 was a Thursday
+inline constexpr std::int64_t FIRST_MONDAY_DAYS = -3;
+
+/**
+ * Index of the candle containing timeStamp
+ * @param timeStamp ms from epoch
+ * @param interval
+ * @return candles from the one open at the epoch, negative before it
+ */
+constexpr std::int64_t intervalIndex(const std::int64_t timeStamp, const CandleInterval interval) {
+    switch (interval) {
+        case CandleInterval::_1M: {
+            int year = 0;
+            int month = 0;
+            int day = 0;
+            civilFromDays(floorDiv(timeStamp, 86400000), year, month, day);
+            return (static_cast<std::int64_t>(year) - 1970) * 12 + month - 1;
+        }
+        case CandleInterval::_1w:
+            return floorDiv(floorDiv(timeStamp, 86400000) - FIRST_MONDAY_DAYS, 7);
+        default:
+            return floorDiv(timeStamp, static_cast<std::int64_t>(interval) * 1000);
+    }
+}
+
+/**
+ * Open time of the candle with the given index, inverse of intervalIndex
+ * @param index
+ * @param interval
+ * @return ms from epoch
+ */
+constexpr std::int64_t intervalStart(const std::int64_t index, const CandleInterval interval) {
+    switch (interval) {
+        case CandleInterval::_1M: {
+            const std::int64_t year = 1970 + floorDiv(index, 12);
+            const int month = static_cast<int>(index - floorDiv(index, 12) * 12) + 1;
+            return daysFromCivil(static_cast<int>(year), month, 1) * 86400000;
+        }
+        case CandleInterval::_1w:
+            return (index * 7 + FIRST_MONDAY_DAYS) * 86400000;
+        default:
+            return index * static_cast<std::int64_t>(interval) * 1000;
+    }
+}
+
+/**
+ * Open time of the candle containing timeStamp
+ * @param timeStamp ms from epoch
+ * @param interval
+ * @return last candle boundary <= timeStamp
+ */
+constexpr std::int64_t floorToInterval(const std::int64_t timeStamp, const CandleInterval interval) {
+    return intervalStart(intervalIndex(timeStamp, interval), interval);
+}
+
+/**
+ * @param timeStamp ms from epoch
+ * @param interval
+ * @return first candle boundary >= timeStamp
+ */
+constexpr std::int64_t ceilToInterval(const std::int64_t timeStamp, const CandleInterval interval) {
+    const std::int64_t index = intervalIndex(timeStamp, interval);
+    const std::int64_t start = intervalStart(index, interval);
+    return start == timeStamp ? start : intervalStart(index + 1, interval);
+}
+
+/**
+ * @param timeStamp ms from epoch
+ * @param interval
+ * @return first candle boundary > timeStamp, the close time of the candle containing timeStamp plus 1 ms
+ */
+constexpr std::int64_t nextIntervalStart(const std::int64_t timeStamp, const CandleInterval interval) {
+    return intervalStart(intervalIndex(timeStamp, interval) + 1, interval);
+}
+
+/**
+ * Number of candles opening in [from, to), e.g. the expected number of candles for a download
+ * @param from ms from epoch
+ * @param to ms from epoch
+ * @param interval
+ * @return 0 if to <= from
+ */
+constexpr std::int64_t countIntervals(const std::int64_t from, const std::int64_t to, const CandleInterval interval) {
+    if (to <= from) {
+        return 0;
+    }
+    const std::int64_t first = intervalIndex(from, interval) + (floorToInterval(from, interval) != from);
+    const std::int64_t end = intervalIndex(to, interval) + (floorToInterval(to, interval) != to);
+    return end - first;
+}
+
+/**
+ * Open times of the candles opening in [from, to)
+ * @param from ms from epoch
+ * @param to ms from epoch
+ * @param interval
+ * @return ascending candle boundaries
+ */
+inline std::vector<std::int64_t> intervalBoundaries(const std::int64_t from, const std::int64_t to,
+                                                    const CandleInterval interval) {
+    std::vector<std::int64_t> retVal;
+    retVal.reserve(static_cast<std::size_t>(countIntervals(from, to, interval)));
+    std::int64_t index = intervalIndex(ceilToInterval(from, interval), interval);
+    for (std::int64_t start = intervalStart(index, interval); start < to; start = intervalStart(++index, interval)) {
+        retVal.push_back(start);
+    }
+    return retVal;
+}
+
+template <CandleInterval Interval>
+constexpr void intervalIndices(const std::span<const std::int64_t> timeStamps, const std::span<std::int64_t> indices) {
+    const std::size_t count = std::min(timeStamps.size(), indices.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        indices[i] = intervalIndex(timeStamps[i], Interval);
+    }
+}
+
+/**
+ * Batch intervalIndex, e.g. for resampling or finding gaps (consecutive indices differing by more than 1).
+ * Fixed intervals divide by compile-time constants.
+ * @param timeStamps ms from epoch
+ * @param interval
+ * @param indices receives min of both sizes elements
+ */
+constexpr void intervalIndices(const std::span<const std::int64_t> timeStamps, const CandleInterval interval,
+                               const std::span<std::int64_t> indices) {
+    switch (interval) {
+        case CandleInterval::_1m: return intervalIndices<CandleInterval::_1m>(timeStamps, indices);
+        case CandleInterval::_3m: return intervalIndices<CandleInterval::_3m>(timeStamps, indices);
+        case CandleInterval::_5m: return intervalIndices<CandleInterval::_5m>(timeStamps, indices);
+        case CandleInterval::_15m: return intervalIndices<CandleInterval::_15m>(timeStamps, indices);
+        case CandleInterval::_30m: return intervalIndices<CandleInterval::_30m>(timeStamps, indices);
+        case CandleInterval::_1h: return intervalIndices<CandleInterval::_1h>(timeStamps, indices);
+        case CandleInterval::_2h: return intervalIndices<CandleInterval::_2h>(timeStamps, indices);
+        case CandleInterval::_4h: return intervalIndices<CandleInterval::_4h>(timeStamps, indices);
+        case CandleInterval::_6h: return intervalIndices<CandleInterval::_6h>(timeStamps, indices);
+        case CandleInterval::_8h: return intervalIndices<CandleInterval::_8h>(timeStamps, indices);
+        case CandleInterval::_12h: return intervalIndices<CandleInterval::_12h>(timeStamps, indices);
+        case CandleInterval::_1d: return intervalIndices<CandleInterval::_1d>(timeStamps, indices);
+        case CandleInterval::_3d: return intervalIndices<CandleInterval::_3d>(timeStamps, indices);
+        case CandleInterval::_1w: return intervalIndices<CandleInterval::_1w>(timeStamps, indices);
+        case CandleInterval::_1M: return intervalIndices<CandleInterval::_1M>(timeStamps, indices);
+    }
+    const std::size_t count = std::min(timeStamps.size(), indices.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        indices[i] = intervalIndex(timeStamps[i], interval);
+    }
+}
+}
+
+#endif // INCLUDE_VK_UTILS_INTERVAL_UTILS_H
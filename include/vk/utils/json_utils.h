@@ -12,8 +12,175 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 #include <nlohmann/json.hpp>
 #include <boost/multiprecision/cpp_dec_float.hpp>
 #include "vk/utils/magic_enum_wrapper.hpp"
+#include "vk/utils/decimal64.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <limits>
+#include <string_view>
 
 namespace vk {
+/**
+ * json.find(key) without a temporary std::string where nlohmann::json supports it (3.11+)
+ * @param json
+ * @param key
+ * @return
+ */
+inline nlohmann::json::const_iterator findKey(const nlohmann::json& json, const std::string_view key) {
+#if NLOHMANN_JSON_VERSION_MAJOR > 3 || (NLOHMANN_JSON_VERSION_MAJOR == 3 && NLOHMANN_JSON_VERSION_MINOR >= 11)
+    return json.find(key);
+#else
+    return json.find(std::string(key));
+#endif
+}
+
+/**
+ * Parse the number at the beginning of s with std::from_chars. Like std::stod and friends it skips leading white
+ * space, accepts a leading '+' and ignores characters after the number, but it neither allocates nor throws.
+ * Unlike std::stod, hexadecimal floats such as "0x10" are not accepted, and denormal values such as "1e-310" are
+ * parsed where std::stod reports them out of range, so readStringAsDouble returns them instead of defaultVal.
+ * @tparam T arithmetic type
+ * @param s
+ * @param value untouched if parsing fails
+ * @return false if s does not start with a number or the number is out of range of T
+ */
+template <typename T>
+bool parseNumber(std::string_view s, T& value) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) {
+        s.remove_prefix(1);
+    }
+
+    if (s.size() > 1 && s.front() == '+' && s[1] != '-') {
+        s.remove_prefix(1);
+    }
+
+    T retVal;
+
+    if (const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), retVal); ec == std::errc()) {
+        value = retVal;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * Precomputed lookup of several attributes in many objects of the same shape, e.g. each element of a candle or
+ * funding rate array. Objects of nlohmann::json are sorted maps, so all the keys are found in one ordered walk over
+ * the object instead of a tree lookup per key. The positions found in the previous object are tried first, objects
+ * with the same attributes cost one comparison per key then. Keeps the positions, so one instance must not be used by
+ * more threads at once.
+ *
+ * @code
+ * vk::JsonKeys keys("t", "o", "c");
+ * for (const auto& el : json) {
+ *     const auto values = keys.find(el);
+ *     readValue(values[0], candle.openTime);
+ *     candle.open = readStringAsDouble(values[1]);
+ *     ...
+ * @endcode
+ * @tparam N number of keys
+ */
+template <std::size_t N>
+class JsonKeys {
+    static constexpr std::size_t NOT_FOUND = static_cast<std::size_t>(-1);
+
+    std::array<std::string, N> m_keys;
+
+    /// Indices of m_keys in the order of the keys
+    std::array<std::size_t, N> m_order{};
+
+    /// Positions of the keys in the order of the keys within the previous object
+    std::array<std::size_t, N> m_positions{};
+
+public:
+    using Values = std::array<const nlohmann::json*, N>;
+
+    template <typename... Keys>
+        requires (sizeof...(Keys) == N)
+    explicit JsonKeys(const Keys&... keys) : m_keys{std::string(keys)...} {
+        for (std::size_t i = 0; i < N; ++i) {
+            m_order[i] = i;
+        }
+
+        std::ranges::sort(m_order, [this](const std::size_t a, const std::size_t b) { return m_keys[a] < m_keys[b]; });
+        m_positions.fill(NOT_FOUND);
+    }
+
+    [[nodiscard]] const std::string& key(const std::size_t index) const {
+        return m_keys[index];
+    }
+
+    /**
+     * Find all keys in json
+     * @param json
+     * @return values in the order of the constructor arguments, nullptr for missing attributes or if json is not
+     * an object
+     */
+    Values find(const nlohmann::json& json) {
+        Values retVal{};
+
+        if (!json.is_object()) {
+            return retVal;
+        }
+
+        auto it = json.cbegin();
+        const auto end = json.cend();
+        std::size_t position = 0;
+
+        for (std::size_t i = 0; i < N; ++i) {
+            const std::string& key = m_keys[m_order[i]];
+
+            if (m_positions[i] != NOT_FOUND && m_positions[i] >= position && m_positions[i] < json.size()) {
+                const auto candidate = std::next(it, static_cast<std::ptrdiff_t>(m_positions[i] - position));
+
+                if (candidate.key() == key) {
+                    retVal[m_order[i]] = &*candidate;
+                    it = std::next(candidate);
+                    position = m_positions[i] + 1;
+                    continue;
+                }
+            }
+
+            while (it != end && it.key() < key) {
+                ++it;
+                ++position;
+            }
+
+            if (it != end && it.key() == key) {
+                retVal[m_order[i]] = &*it;
+                m_positions[i] = position;
+                ++it;
+                ++position;
+            }
+            else {
+                m_positions[i] = NOT_FOUND;
+            }
+        }
+
+        return retVal;
+    }
+};
+
+template <typename... Keys>
+JsonKeys(const Keys&...) -> JsonKeys<sizeof...(Keys)>;
+
+/**
+ * Helper for reading an attribute found by JsonKeys.
+ * @tparam ValueType
+ * @param attribute
+ * @param value
+ * @return true if attribute is not nullptr and not null
+ */
+template <typename ValueType>
+bool readValue(const nlohmann::json* attribute, ValueType& value) {
+    if (attribute && !attribute->is_null()) {
+        value = *attribute;
+        return true;
+    }
+    return false;
+}
 /**
  * Helper for reading a value from nlohmann::json object.
  * @tparam ValueType
@@ -24,8 +191,8 @@ namespace vk {
  * @return true if succeeded and canThrow parameter is false
  */
 template <typename ValueType>
-bool readValue(const nlohmann::json& json, const std::string& key, ValueType& value, const bool canThrow = false) {
-    const auto it = json.find(key);
+bool readValue(const nlohmann::json& json, const std::string_view key, ValueType& value, const bool canThrow = false) {
+    const auto it = findKey(json, key);
 
     if (canThrow) {
         if (!it.value().is_null()) {
@@ -44,105 +211,181 @@ bool readValue(const nlohmann::json& json, const std::string& key, ValueType& va
 
 /**
  * Helper for reading a string value from nlohmann::json object and transform it to double.
- * @param json
- * @param key
+ * @param attribute value of the attribute, e.g. found by JsonKeys, may be nullptr
  * @param defaultVal Will be used if value cannot be found or of it is not transformable into double.
  * @return
  */
-inline double readStringAsDouble(const nlohmann::json& json, const std::string& key, const double defaultVal = 0.0) {
-    const auto it = json.find(key);
+inline double readStringAsDouble(const nlohmann::json* attribute, const double defaultVal = 0.0) {
+    double retVal = defaultVal;
 
-    try {
-        if (it != json.end()) {
-            if (!it.value().is_null() && it.value().is_string()) {
-                return std::stod(it->get<std::string>());
-            }
-        }
-    }
-    catch (std::invalid_argument&) {
-    }
-    catch (std::out_of_range&) {
+    if (attribute && attribute->is_string()) {
+        parseNumber(attribute->get_ref<const std::string&>(), retVal);
     }
 
-    return defaultVal;
+    return retVal;
+}
+
+inline double readStringAsDouble(const nlohmann::json& json, const std::string_view key, const double defaultVal = 0.0) {
+    const auto it = findKey(json, key);
+    return readStringAsDouble(it != json.end() ? &*it : nullptr, defaultVal);
 }
 
 /**
  * Helper for reading a string value from nlohmann::json object and transform it to Integer.
- * @param json
- * @param key
+ * @param attribute value of the attribute, e.g. found by JsonKeys, may be nullptr
  * @param defaultVal
  * @return
  */
-inline int readStringAsInt(const nlohmann::json& json, const std::string& key, const int defaultVal = 0) {
-    const auto it = json.find(key);
+inline int readStringAsInt(const nlohmann::json* attribute, const int defaultVal = 0) {
+    int retVal = defaultVal;
 
-    try {
-        if (it != json.end()) {
-            if (!it.value().is_null() && it.value().is_string()) {
-                return std::stoi(it->get<std::string>());
-            }
-        }
-    }
-    catch (std::invalid_argument&) {
-    }
-    catch (std::out_of_range&) {
+    if (attribute && attribute->is_string()) {
+        parseNumber(attribute->get_ref<const std::string&>(), retVal);
     }
 
-    return defaultVal;
+    return retVal;
+}
+
+inline int readStringAsInt(const nlohmann::json& json, const std::string_view key, const int defaultVal = 0) {
+    const auto it = findKey(json, key);
+    return readStringAsInt(it != json.end() ? &*it : nullptr, defaultVal);
 }
 
 /**
  * Helper for reading a string value from nlohmann::json object and transform it to 64b Integer.
- * @param json
- * @param key
+ * @param attribute value of the attribute, e.g. found by JsonKeys, may be nullptr
  * @param defaultVal
  * @return
  */
-inline int64_t readStringAsInt64(const nlohmann::json& json, const std::string& key, const int64_t defaultVal = 0) {
-    const auto it = json.find(key);
+inline int64_t readStringAsInt64(const nlohmann::json* attribute, const int64_t defaultVal = 0) {
+    int64_t retVal = defaultVal;
 
-    try {
-        if (it != json.end()) {
-            if (!it.value().is_null() && it.value().is_string()) {
-                return std::stoll(it->get<std::string>());
-            }
-        }
-    }
-    catch (std::invalid_argument&) {
-    }
-    catch (std::out_of_range&) {
+    if (attribute && attribute->is_string()) {
+        parseNumber(attribute->get_ref<const std::string&>(), retVal);
     }
 
-    return defaultVal;
+    return retVal;
+}
+
+inline int64_t readStringAsInt64(const nlohmann::json& json, const std::string_view key, const int64_t defaultVal = 0) {
+    const auto it = findKey(json, key);
+    return readStringAsInt64(it != json.end() ? &*it : nullptr, defaultVal);
 }
 
 /**
  * Helper for reading a decimal value from nlohmann::json object.
- * @param json
- * @param key
+ * @param attribute value of the attribute, e.g. found by JsonKeys, may be nullptr
  * @param defaultVal
  * @return decimal value
  */
+inline boost::multiprecision::cpp_dec_float_50 readDecimalValue(const nlohmann::json* attribute,
+                                                                boost::multiprecision::cpp_dec_float_50 defaultVal =
+                                                                    boost::multiprecision::cpp_dec_float_50("0")) {
+    if (attribute) {
+        if (attribute->is_string() && !attribute->get_ref<const std::string&>().empty()) {
+            return boost::multiprecision::cpp_dec_float_50(attribute->get_ref<const std::string&>());
+        }
+        if (attribute->is_number_unsigned()) {
+            return boost::multiprecision::cpp_dec_float_50(attribute->get<std::uint64_t>());
+        }
+        if (attribute->is_number_integer()) {
+            return boost::multiprecision::cpp_dec_float_50(attribute->get<std::int64_t>());
+        }
+        if (attribute->is_number_float()) {
+            // The shortest form reading back as the same double, std::to_string would round to 6 decimal places
+            std::array<char, 32> buffer{};
+            std::to_chars(buffer.data(), buffer.data() + buffer.size() - 1, attribute->get<double>());
+            return boost::multiprecision::cpp_dec_float_50(buffer.data());
+        }
+    }
+
+    return defaultVal;
+}
+
 inline boost::multiprecision::cpp_dec_float_50 readDecimalValue(const nlohmann::json& json,
-                                                                const std::string& key,
+                                                                const std::string_view key,
                                                                 boost::multiprecision::cpp_dec_float_50 defaultVal =
                                                                     boost::multiprecision::cpp_dec_float_50("0")) {
-    if (const auto it = json.find(key); it != json.end()) {
-        if (!it.value().is_null()) {
-            if (it->is_string() && !it->get<std::string>().empty()) {
-                return boost::multiprecision::cpp_dec_float_50(it->get<std::string>());
-            }
-            if (it->is_number()) {
-                return boost::multiprecision::cpp_dec_float_50(std::to_string(it->get<double>()));
-            }
+    const auto it = findKey(json, key);
+    return readDecimalValue(it != json.end() ? &*it : nullptr, std::move(defaultVal));
+}
+
+/**
+ * Helper for reading a Decimal64 value from nlohmann::json object. Strings are parsed exactly, numbers parsed by
+ * nlohmann::json as double are taken in their shortest decimal form, so 0.1 is read as 0.1 with scale 1.
+ * @param attribute value of the attribute, e.g. found by JsonKeys, may be nullptr
+ * @param defaultVal Will be used if value cannot be found or is not representable, see Decimal64::parse
+ * @return
+ */
+inline Decimal64 readDecimal64Value(const nlohmann::json* attribute, const Decimal64 defaultVal = {}) {
+    if (attribute) {
+        if (attribute->is_string()) {
+            return Decimal64::parse(attribute->get_ref<const std::string&>()).value_or(defaultVal);
+        }
+        if (attribute->is_number_unsigned()) {
+            const auto value = attribute->get<std::uint64_t>();
+            return value <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())
+                       ? Decimal64(static_cast<std::int64_t>(value), 0)
+                       : defaultVal;
+        }
+        if (attribute->is_number_integer()) {
+            return {attribute->get<std::int64_t>(), 0};
+        }
+        if (attribute->is_number_float()) {
+            return Decimal64::fromDouble(attribute->get<double>()).value_or(defaultVal);
+        }
+    }
+
+    return defaultVal;
+}
+
+inline Decimal64 readDecimal64Value(const nlohmann::json& json, const std::string_view key,
+                                    const Decimal64 defaultVal = {}) {
+    const auto it = findKey(json, key);
+    return readDecimal64Value(it != json.end() ? &*it : nullptr, defaultVal);
+}
+
+/**
+ * Helper for reading a Decimal64 value in the precision of its symbol from nlohmann::json object. Named apart from
+ * readDecimal64Value so that a braced default value is never taken for the scale.
+ * @param attribute value of the attribute, e.g. found by JsonKeys, may be nullptr
+ * @param scale number of decimal places of the result, the digits beyond are rounded by mode
+ * @param defaultVal Will be used if value cannot be found or is out of range, returned as it is
+ * @param mode
+ * @return
+ */
+inline Decimal64 readDecimal64ValueScaled(const nlohmann::json* attribute, const int scale,
+                                          const Decimal64 defaultVal = {},
+                                          const RoundingMode mode = RoundingMode::HalfEven) {
+    if (attribute) {
+        if (attribute->is_string()) {
+            return Decimal64::parse(attribute->get_ref<const std::string&>(), scale, mode).value_or(defaultVal);
+        }
+        if (attribute->is_number_integer()) {
+            std::array<char, 24> buffer{};
+            const auto [ptr, ec] = attribute->is_number_unsigned()
+                                       ? std::to_chars(buffer.data(), buffer.data() + buffer.size(),
+                                                       attribute->get<std::uint64_t>())
+                                       : std::to_chars(buffer.data(), buffer.data() + buffer.size(),
+                                                       attribute->get<std::int64_t>());
+            return Decimal64::parse(std::string_view(buffer.data(), ptr - buffer.data()), scale, mode)
+                .value_or(defaultVal);
+        }
+        if (attribute->is_number_float()) {
+            return Decimal64::fromDouble(attribute->get<double>(), scale, mode).value_or(defaultVal);
         }
-        return defaultVal;
     }
 
     return defaultVal;
 }
 
+inline Decimal64 readDecimal64ValueScaled(const nlohmann::json& json, const std::string_view key, const int scale,
+                                          const Decimal64 defaultVal = {},
+                                          const RoundingMode mode = RoundingMode::HalfEven) {
+    const auto it = findKey(json, key);
+    return readDecimal64ValueScaled(it != json.end() ? &*it : nullptr, scale, defaultVal, mode);
+}
+
 /**
  * Helper for reading a Better Enum value (http://github.com/aantron/better-enums) from nlohmann::json object.
  * @tparam ValueType
@@ -153,8 +396,8 @@ inline boost::multiprecision::cpp_dec_float_50 readDecimalValue(const nlohmann::
  * @return true if succeeded and canThrow parameter is false
  */
 template <typename ValueType>
-bool readEnum(const nlohmann::json& json, const std::string& key, ValueType& value, const bool canThrow = false) {
-    const auto it = json.find(key);
+bool readEnum(const nlohmann::json& json, const std::string_view key, ValueType& value, const bool canThrow = false) {
+    const auto it = findKey(json, key);
 
     if (canThrow) {
         if (!it.value().is_null()) {
@@ -171,6 +414,22 @@ bool readEnum(const nlohmann::json& json, const std::string& key, ValueType& val
     return false;
 }
 
+/**
+ * Helper for reading a Better Enum value (http://github.com/aantron/better-enums) found by JsonKeys.
+ * @tparam ValueType
+ * @param attribute
+ * @param value
+ * @return true if attribute is a non-empty string
+ */
+template <typename ValueType>
+bool readEnum(const nlohmann::json* attribute, ValueType& value) {
+    if (attribute && attribute->is_string() && !attribute->get_ref<const std::string&>().empty()) {
+        value = ValueType::_from_string_nocase(attribute->get_ref<const std::string&>().c_str());
+        return true;
+    }
+    return false;
+}
+
 /**
  * Helper for reading a Better Enum value (https://github.com/Neargye/magic_enum) from nlohmann::json object.
  * @tparam ValueType
@@ -181,8 +440,9 @@ bool readEnum(const nlohmann::json& json, const std::string& key, ValueType& val
  * @return true if succeeded and canThrow parameter is false
  */
 template <typename ValueType>
-bool readMagicEnum(const nlohmann::json& json, const std::string& key, ValueType& value, const bool canThrow = false) {
-    const auto it = json.find(key);
+bool readMagicEnum(const nlohmann::json& json, const std::string_view key, ValueType& value,
+                   const bool canThrow = false) {
+    const auto it = findKey(json, key);
 
     if (canThrow) {
         if (!it.value().is_null()) {
@@ -207,6 +467,26 @@ bool readMagicEnum(const nlohmann::json& json, const std::string& key, ValueType
     return false;
 }
 
+/**
+ * Helper for reading a magic_enum value found by JsonKeys.
+ * @tparam ValueType
+ * @param attribute
+ * @param value
+ * @return true if attribute is a string naming a value of ValueType
+ */
+template <typename ValueType>
+bool readMagicEnum(const nlohmann::json* attribute, ValueType& value) {
+    if (attribute && attribute->is_string()) {
+        const auto v = magic_enum::enum_cast<ValueType>(attribute->get_ref<const std::string&>(),
+                                                        magic_enum::case_insensitive);
+        if (v) {
+            value = *v;
+            return true;
+        }
+    }
+    return false;
+}
+
 inline std::string queryStringFromJson(const nlohmann::json& pars) {
     std::string queryStr;
 
@@ -0,0 +1,519 @@
+/**
+Time Utilities
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_TIME_UTILS_H
+#define INCLUDE_VK_UTILS_TIME_UTILS_H
+
+#include "vk/utils/utils.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <ctime>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace vk {
+/**
+ * Broken-down UTC time filled by TimeFormat::parse, fields missing in the format keep their values
+ */
+struct TimeFields {
+    int year = 1970;
+    int month = 1;
+    int day = 1;
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int millisecond = 0;
+    /// offset of the parsed time from UTC in seconds, from %z
+    int utcOffset = 0;
+
+    [[nodiscard]] constexpr std::int64_t toSeconds() const {
+        return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - utcOffset;
+    }
+
+    [[nodiscard]] constexpr std::int64_t toMilliseconds() const {
+        return toSeconds() * 1000 + millisecond;
+    }
+
+    /**
+     * @return tm of the local time as written, utcOffset is not applied
+     */
+    [[nodiscard]] std::tm toTm() const {
+        std::tm retVal{};
+        retVal.tm_year = year - 1900;
+        retVal.tm_mon = month - 1;
+        retVal.tm_mday = day;
+        retVal.tm_hour = hour;
+        retVal.tm_min = minute;
+        retVal.tm_sec = second;
+        return retVal;
+    }
+};
+
+/**
+ * strftime-like date-time format compiled into a list of fields, parses and formats without locales or allocations.
+ * Supported: %Y %m %d %H %M %S %z %F %T %R %%, %Ez and %Oz as %z. %S also takes a fraction (".873" or ",873")
+ * unless the format itself continues with '.' or ','. %z takes "Z", "+hh", "+hhmm" or "+hh:mm".
+ * A space matches any amount of white space, other characters match themselves.
+ * Numbers may have fewer digits than their full width, like with std::get_time.
+ * Formatting writes numbers zero-padded to their full width, %S without fraction and %z as "+0000".
+ *
+ * constexpr TimeFormat format("%Y-%m-%dT%H:%M:%S%z") compiles the format at compile time,
+ * parseTime<"%Y-%m-%dT%H:%M:%S%z">(...) also unrolls the parser for it.
+ */
+class TimeFormat {
+public:
+    static constexpr std::size_t MAX_TOKENS = 64;
+    /// formatted length can not exceed this, including ".mmm"
+    static constexpr std::size_t MAX_FORMATTED_SIZE = MAX_TOKENS * 11 + 4;
+
+    /**
+     * @param format
+     * @throws std::invalid_argument if the format uses unsupported conversions or is too long
+     */
+    constexpr explicit TimeFormat(const std::string_view format) {
+        if (const char* error = compile(format)) {
+            throw std::invalid_argument(error);
+        }
+    }
+
+    /**
+     * Compile format without throwing, for formats that may not be supported
+     * @param format
+     * @return compiled format, empty if the format uses unsupported conversions or is too long
+     */
+    [[nodiscard]] static constexpr std::optional<TimeFormat> tryCompile(const std::string_view format) {
+        TimeFormat retVal;
+        if (retVal.compile(format) != nullptr) {
+            return std::nullopt;
+        }
+        return retVal;
+    }
+
+    [[nodiscard]] constexpr std::size_t size() const {
+        return m_size;
+    }
+
+    /**
+     * @return number of leading tokens that only depend on the date
+     */
+    [[nodiscard]] constexpr std::size_t datePrefixSize() const {
+        return m_datePrefixSize;
+    }
+
+    /**
+     * @return true if other has the same date-only leading tokens, so both write the same date part
+     */
+    [[nodiscard]] bool hasSameDatePrefix(const TimeFormat& other) const {
+        return m_datePrefixSize == other.m_datePrefixSize &&
+               std::memcmp(m_tokens.data(), other.m_tokens.data(), m_datePrefixSize * sizeof(Token)) == 0;
+    }
+
+    /**
+     * @param isMs whether ".mmm" is added
+     * @return maximum number of chars formatTimeStamp writes
+     */
+    [[nodiscard]] constexpr std::size_t maxFormattedSize(const bool isMs) const {
+        return m_maxFormattedSize + (isMs ? 4 : 0);
+    }
+
+    /**
+     * Write the token at index for fields
+     * @return end of the written chars
+     */
+    constexpr char* formatToken(const std::size_t index, const TimeFields& fields, char* out) const {
+        const Token& token = m_tokens[index];
+        switch (token.kind) {
+            case Kind::Literal:
+            case Kind::Space:
+                *out++ = token.literal;
+                return out;
+            case Kind::Year:
+                if (fields.year < 0 || fields.year > 9999) {
+                    return std::to_chars(out, out + 11, fields.year).ptr;
+                }
+                out = formatNumber(fields.year / 100, out);
+                return formatNumber(fields.year % 100, out);
+            case Kind::Month:
+                return formatNumber(fields.month, out);
+            case Kind::Day:
+                return formatNumber(fields.day, out);
+            case Kind::Hour:
+                return formatNumber(fields.hour, out);
+            case Kind::Minute:
+                return formatNumber(fields.minute, out);
+            case Kind::Second:
+            case Kind::SecondWithFraction:
+                return formatNumber(fields.second, out);
+            case Kind::Zone:
+                return std::copy_n("+0000", 5, out);
+        }
+        return out;
+    }
+
+    /**
+     * Parse as much of timeString as matches the format, trailing characters are ignored
+     * @param timeString
+     * @param fields receives the parsed fields, also those parsed before a mismatch
+     * @return true if the whole format matched
+     */
+    constexpr bool parse(const std::string_view timeString, TimeFields& fields) const {
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            if (!parseToken(i, timeString, pos, fields)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Parse the token at index, used by parseTime to unroll the loop of parse
+     */
+    constexpr bool parseToken(const std::size_t index, const std::string_view str, std::size_t& pos,
+                              TimeFields& fields) const {
+        const Token& token = m_tokens[index];
+        switch (token.kind) {
+            case Kind::Literal:
+                if (pos == str.size() || str[pos] != token.literal) {
+                    return false;
+                }
+                ++pos;
+                return true;
+            case Kind::Space:
+                while (pos < str.size() && (str[pos] == ' ' || str[pos] == '\t' || str[pos] == '\n' || str[pos] == '\r')) {
+                    ++pos;
+                }
+                return true;
+            case Kind::Year:
+                return parseNumber(str, pos, 4, 0, 9999, fields.year);
+            case Kind::Month:
+                return parseNumber(str, pos, 2, 1, 12, fields.month);
+            case Kind::Day:
+                return parseNumber(str, pos, 2, 1, 31, fields.day);
+            case Kind::Hour:
+                return parseNumber(str, pos, 2, 0, 24, fields.hour);
+            case Kind::Minute:
+                return parseNumber(str, pos, 2, 0, 59, fields.minute);
+            case Kind::Second:
+                return parseNumber(str, pos, 2, 0, 60, fields.second);
+            case Kind::SecondWithFraction:
+                if (!parseNumber(str, pos, 2, 0, 60, fields.second)) {
+                    return false;
+                }
+                return parseFraction(str, pos, fields.millisecond);
+            case Kind::Zone:
+                return parseZone(str, pos, fields.utcOffset);
+        }
+        return false;
+    }
+
+private:
+    enum class Kind : std::uint8_t {
+        Literal,
+        Space,
+        Year,
+        Month,
+        Day,
+        Hour,
+        Minute,
+        Second,
+        SecondWithFraction,
+        Zone
+    };
+
+    struct Token {
+        Kind kind = Kind::Literal;
+        char literal = 0;
+    };
+
+    std::array<Token, MAX_TOKENS> m_tokens{};
+    std::size_t m_size = 0;
+    std::size_t m_datePrefixSize = 0;
+    std::size_t m_maxFormattedSize = 0;
+
+    constexpr TimeFormat() = default;
+
+    /**
+     * @return nullptr, or the error message if format is not supported
+     */
+    constexpr const char* compile(const std::string_view format) {
+        for (std::size_t i = 0; i < format.size(); ++i) {
+            if (format[i] != '%') {
+                push(format[i] == ' ' ? Kind::Space : Kind::Literal, format[i]);
+                continue;
+            }
+
+            if (++i == format.size()) {
+                return "Time format ends with %";
+            }
+
+            if (format[i] == 'E' || format[i] == 'O') {
+                if (++i == format.size() || format[i] != 'z') {
+                    return "Unsupported time format modifier";
+                }
+            }
+
+            switch (format[i]) {
+                case 'Y': push(Kind::Year);
+                    break;
+                case 'm': push(Kind::Month);
+                    break;
+                case 'd': push(Kind::Day);
+                    break;
+                case 'H': push(Kind::Hour);
+                    break;
+                case 'M': push(Kind::Minute);
+                    break;
+                case 'S': push(Kind::Second);
+                    break;
+                case 'z': push(Kind::Zone);
+                    break;
+                case 'F': push(Kind::Year);
+                    push(Kind::Literal, '-');
+                    push(Kind::Month);
+                    push(Kind::Literal, '-');
+                    push(Kind::Day);
+                    break;
+                case 'T': push(Kind::Hour);
+                    push(Kind::Literal, ':');
+                    push(Kind::Minute);
+                    push(Kind::Literal, ':');
+                    push(Kind::Second);
+                    break;
+                case 'R': push(Kind::Hour);
+                    push(Kind::Literal, ':');
+                    push(Kind::Minute);
+                    break;
+                case '%': push(Kind::Literal, '%');
+                    break;
+                default:
+                    return "Unsupported time format conversion";
+            }
+        }
+        if (m_size > MAX_TOKENS) {
+            return "Time format is too long";
+        }
+
+        bool isDatePrefix = true;
+        for (std::size_t i = 0; i < m_size; ++i) {
+            const Kind kind = m_tokens[i].kind;
+            isDatePrefix = isDatePrefix && (kind == Kind::Literal || kind == Kind::Space || kind == Kind::Year ||
+                                            kind == Kind::Month || kind == Kind::Day);
+            m_datePrefixSize += isDatePrefix;
+            m_maxFormattedSize += kind == Kind::Year ? 11 : kind == Kind::Zone ? 5 : kind <= Kind::Space ? 1 : 2;
+
+            if (m_tokens[i].kind == Kind::Second &&
+                (i + 1 == m_size || m_tokens[i + 1].kind != Kind::Literal ||
+                 (m_tokens[i + 1].literal != '.' && m_tokens[i + 1].literal != ','))) {
+                m_tokens[i].kind = Kind::SecondWithFraction;
+            }
+        }
+        return nullptr;
+    }
+
+    /// counts tokens past MAX_TOKENS without storing them, compile then fails
+    constexpr void push(const Kind kind, const char literal = 0) {
+        if (m_size < MAX_TOKENS) {
+            m_tokens[m_size] = Token{kind, literal};
+        }
+        ++m_size;
+    }
+
+    static constexpr bool isDigit(const char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    /// two digits of 0..99
+    static constexpr char* formatNumber(const int value, char* out) {
+        *out++ = static_cast<char>('0' + value / 10);
+        *out++ = static_cast<char>('0' + value % 10);
+        return out;
+    }
+
+    static constexpr bool parseNumber(const std::string_view str, std::size_t& pos, const int maxDigits,
+                                      const int min, const int max, int& value) {
+        int result = 0;
+        int digits = 0;
+        while (digits < maxDigits && pos < str.size() && isDigit(str[pos])) {
+            result = result * 10 + (str[pos] - '0');
+            ++pos;
+            ++digits;
+        }
+        if (digits == 0 || result < min || result > max) {
+            return false;
+        }
+        value = result;
+        return true;
+    }
+
+    static constexpr bool parseFraction(const std::string_view str, std::size_t& pos, int& millisecond) {
+        if (pos + 1 >= str.size() || (str[pos] != '.' && str[pos] != ',') || !isDigit(str[pos + 1])) {
+            millisecond = 0;
+            return true;
+        }
+        ++pos;
+        int result = 0;
+        int digits = 0;
+        for (; pos < str.size() && isDigit(str[pos]); ++pos, ++digits) {
+            if (digits < 3) {
+                result = result * 10 + (str[pos] - '0');
+            }
+        }
+        for (; digits < 3; ++digits) {
+            result *= 10;
+        }
+        millisecond = result;
+        return true;
+    }
+
+    static constexpr bool parseZone(const std::string_view str, std::size_t& pos, int& utcOffset) {
+        if (pos == str.size()) {
+            return false;
+        }
+        if (str[pos] == 'Z' || str[pos] == 'z') {
+            ++pos;
+            utcOffset = 0;
+            return true;
+        }
+        if (str[pos] != '+' && str[pos] != '-') {
+            return false;
+        }
+        const int sign = str[pos] == '-' ? -1 : 1;
+        ++pos;
+
+        int hours = 0;
+        if (pos + 2 > str.size() || !isDigit(str[pos]) || !isDigit(str[pos + 1])) {
+            return false;
+        }
+        hours = (str[pos] - '0') * 10 + (str[pos + 1] - '0');
+        pos += 2;
+
+        int minutes = 0;
+        std::size_t minutesPos = pos < str.size() && str[pos] == ':' ? pos + 1 : pos;
+        if (minutesPos + 2 <= str.size() && isDigit(str[minutesPos]) && isDigit(str[minutesPos + 1])) {
+            minutes = (str[minutesPos] - '0') * 10 + (str[minutesPos + 1] - '0');
+            pos = minutesPos + 2;
+        }
+
+        if (hours > 23 || minutes > 59) {
+            return false;
+        }
+        utcOffset = sign * (hours * 3600 + minutes * 60);
+        return true;
+    }
+};
+
+/**
+ * String literal usable as a template argument
+ */
+template <std::size_t N>
+struct FixedString {
+    char data[N]{};
+
+    constexpr FixedString(const char (&str)[N]) {
+        std::copy_n(str, N, data);
+    }
+
+    [[nodiscard]] constexpr std::string_view view() const {
+        return {data, N - 1};
+    }
+};
+
+template <FixedString Format>
+inline constexpr TimeFormat compiledTimeFormat{Format.view()};
+
+/**
+ * Write timeStamp as UTC time in format, thread-safe. Each thread keeps the formatted date part of the last
+ * day it formatted, so only the time of day is formatted while the day does not change.
+ * @param format
+ * @param timeStamp seconds or ms from epoch
+ * @param isMs timeStamp is in ms, ".mmm" is appended
+ * @param out room for at least format.maxFormattedSize(isMs) chars, not NUL terminated
+ * @return end of the written chars
+ */
+inline char* formatTimeStamp(const TimeFormat& format, const std::int64_t timeStamp, const bool isMs, char* out) {
+    struct DayCache {
+        TimeFormat format{""};
+        std::int64_t day = std::numeric_limits<std::int64_t>::min();
+        TimeFields fields;
+        std::size_t size = 0;
+        char text[TimeFormat::MAX_FORMATTED_SIZE];
+    };
+    static thread_local DayCache cache;
+
+    std::int64_t secs = timeStamp;
+    int ms = 0;
+    if (isMs) {
+        secs = timeStamp / 1000 - (timeStamp % 1000 < 0);
+        ms = static_cast<int>(timeStamp - secs * 1000);
+    }
+    const std::int64_t day = secs / 86400 - (secs % 86400 < 0);
+    const int secOfDay = static_cast<int>(secs - day * 86400);
+
+    if (cache.day != day || !format.hasSameDatePrefix(cache.format)) {
+        civilFromDays(day, cache.fields.year, cache.fields.month, cache.fields.day);
+        char* end = cache.text;
+        for (std::size_t i = 0; i < format.datePrefixSize(); ++i) {
+            end = format.formatToken(i, cache.fields, end);
+        }
+        cache.size = end - cache.text;
+        cache.day = day;
+        cache.format = format;
+    }
+
+    out = std::copy_n(cache.text, cache.size, out);
+    TimeFields fields = cache.fields;
+    fields.hour = secOfDay / 3600;
+    fields.minute = secOfDay / 60 % 60;
+    fields.second = secOfDay % 60;
+    for (std::size_t i = format.datePrefixSize(); i < format.size(); ++i) {
+        out = format.formatToken(i, fields, out);
+    }
+
+    if (isMs) {
+        *out++ = '.';
+        *out++ = static_cast<char>('0' + ms / 100);
+        *out++ = static_cast<char>('0' + ms / 10 % 10);
+        *out++ = static_cast<char>('0' + ms % 10);
+    }
+    return out;
+}
+
+/**
+ * Append timeStamp formatted by formatTimeStamp to out
+ */
+inline void formatTimeStamp(const TimeFormat& format, const std::int64_t timeStamp, const bool isMs,
+                            fmt::memory_buffer& out) {
+    const std::size_t size = out.size();
+    out.resize(size + format.maxFormattedSize(isMs));
+    out.resize(formatTimeStamp(format, timeStamp, isMs, out.data() + size) - out.data());
+}
+
+/**
+ * TimeFormat::parse with the format compiled at compile time and the parser unrolled for it
+ * @tparam Format e.g. "%Y-%m-%dT%H:%M:%S%z"
+ * @param timeString e.g. "2022-01-28T21:45:00.123+00:00"
+ * @param fields receives the parsed fields
+ * @return true if the whole format matched
+ */
+template <FixedString Format>
+constexpr bool parseTime(const std::string_view timeString, TimeFields& fields) {
+    constexpr const TimeFormat& format = compiledTimeFormat<Format>;
+    std::size_t pos = 0;
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return (format.parseToken(I, timeString, pos, fields) && ...);
+    }(std::make_index_sequence<format.size()>{});
+}
+}
+
+#endif // INCLUDE_VK_UTILS_TIME_UTILS_H
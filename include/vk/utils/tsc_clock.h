@@ -0,0 +1,106 @@
+/**
+TSC Clock
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#ifndef INCLUDE_VK_UTILS_TSC_CLOCK_H
+#define INCLUDE_VK_UTILS_TSC_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VK_TSC_CLOCK_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace vk {
+/**
+ * Wall clock reading the invariant TSC instead of calling std::chrono::system_clock::now(). Cycles are converted
+ * to ns by a scale calibrated against system_clock on the first call (or by calibrate()) and recalibrated after every
+ * RECALIBRATION_PERIOD, so the clock follows NTP adjustments of system_clock. Without an invariant TSC, or on
+ * non-x86 CPUs, now() falls back to system_clock::now(). Like system_clock it is not steady, a recalibration may
+ * move it by the drift accumulated since the previous one.
+ *
+ * Meets the Clock requirements, its time_point is the system_clock one.
+ */
+class TscClock {
+public:
+    using duration = std::chrono::system_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::system_clock::time_point;
+    static constexpr bool is_steady = false;
+
+    static constexpr std::chrono::seconds RECALIBRATION_PERIOD{1};
+
+    static time_point now() noexcept {
+#ifdef VK_TSC_CLOCK_X86
+        const std::uint64_t sequence = s_sequence.load(std::memory_order_acquire);
+        const std::uint64_t tsc = __rdtsc();
+        const std::uint64_t baseTsc = s_baseTsc.load(std::memory_order_relaxed);
+        const std::int64_t baseNs = s_baseNs.load(std::memory_order_relaxed);
+        const std::uint64_t scale = s_scale.load(std::memory_order_relaxed);
+        const std::uint64_t maxCycles = s_maxCycles.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // 0: not calibrated or no invariant TSC, odd: being recalibrated, cycles wrap below baseTsc
+        if (const std::uint64_t cycles = tsc - baseTsc;
+            sequence != 0 && (sequence & 1) == 0 && cycles < maxCycles &&
+            s_sequence.load(std::memory_order_relaxed) == sequence) {
+            return time_point(std::chrono::duration_cast<duration>(
+                std::chrono::nanoseconds(baseNs + static_cast<std::int64_t>(cyclesToNs(cycles, scale)))));
+        }
+        return slowNow();
+#else
+        return std::chrono::system_clock::now();
+#endif
+    }
+
+    /**
+     * Calibrate the clock now instead of on the first now() call, e.g. at application startup. Blocks for about
+     * 10 ms, does nothing when already calibrated
+     * @return true if now() reads the TSC, false if it falls back to system_clock
+     */
+    static bool calibrate();
+
+    /**
+     * @return true if now() reads the TSC, false if it falls back to system_clock, calibrates when not done yet
+     */
+    [[nodiscard]] static bool isTscUsed();
+
+private:
+#ifdef VK_TSC_CLOCK_X86
+    /// scale is ns per cycle in 32.32 fixed point
+    static std::uint64_t cyclesToNs(const std::uint64_t cycles, const std::uint64_t scale) noexcept {
+#ifdef _MSC_VER
+        std::uint64_t high;
+        const std::uint64_t low = _umul128(cycles, scale, &high);
+        return high << 32 | low >> 32;
+#else
+        return static_cast<std::uint64_t>(static_cast<unsigned __int128>(cycles) * scale >> 32);
+#endif
+    }
+#endif
+
+    static time_point slowNow() noexcept;
+
+    static void publish(std::uint64_t tsc, std::int64_t ns, std::uint64_t scale) noexcept;
+
+    /// Seqlock over the calibration below, odd while it is being written
+    static inline std::atomic<std::uint64_t> s_sequence{0};
+    static inline std::atomic<std::uint64_t> s_baseTsc{0};
+    static inline std::atomic<std::int64_t> s_baseNs{0};
+    static inline std::atomic<std::uint64_t> s_scale{0};
+    static inline std::atomic<std::uint64_t> s_maxCycles{0};
+};
+}
+#endif // INCLUDE_VK_UTILS_TSC_CLOCK_H
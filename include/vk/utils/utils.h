@@ -11,12 +11,20 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 
 #include <chrono>
 #include <string>
+#include <string_view>
 #include <spdlog/fmt/ostr.h>
 #include <vector>
 #include <map>
 #include <filesystem>
 #include <algorithm>
 #include <cstdint>
+#include <ctime>
+#include <span>
+#include "vk/utils/civil_date.h"
+
+#ifdef VK_TSC_CLOCK
+#include "vk/utils/tsc_clock.h"
+#endif
 
 namespace vk {
 typedef double DATE;
@@ -30,7 +38,7 @@ typedef struct T6 {
 
 inline DATE convertTimeMs(const std::int64_t t64) {
     if (t64 == 0) return 0.;
-    return (25569. + static_cast<double>(t64 / 1000) / (24. * 60. * 60.));
+    return (25569. + static_cast<double>(t64) / (24. * 60. * 60. * 1000.));
 }
 
 #if defined __linux__
@@ -52,28 +60,78 @@ inline std::int64_t convertTimeS(const DATE Date) {
     return static_cast<std::int64_t>((Date - 25569.) * 24. * 60. * 60.);
 }
 
+/**
+ * Batch convertTimeMs(std::int64_t) using SIMD, keeps milliseconds. 0 is converted to 0.
+ * @param timeStamps ms from epoch, at most 2^51 in magnitude
+ * @param dates receives min of both sizes elements
+ */
+void convertTimeMs(std::span<const std::int64_t> timeStamps, std::span<DATE> dates);
+
+/**
+ * Batch DATE to ms from epoch using SIMD, rounds to the nearest ms instead of truncating to seconds like
+ * convertTimeMs(DATE)
+ * @param dates
+ * @param timeStamps receives min of both sizes elements
+ */
+void convertTimeMs(std::span<const DATE> dates, std::span<std::int64_t> timeStamps);
+
 using Clock = std::chrono::system_clock;
 using TimePoint = std::chrono::time_point<Clock>;
 
 constexpr char hexMap[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
+/**
+ * @return system_clock::now(), or vk::TscClock::now() when built with VK_TSC_CLOCK (CMake option TSC_CLOCK)
+ */
 inline TimePoint currentTime() {
+#ifdef VK_TSC_CLOCK
+    return TscClock::now();
+#else
     return Clock::now();
+#endif
 }
 
 inline std::chrono::milliseconds getMsTimestamp(const TimePoint time) {
     return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch());
 }
 
+/**
+ * Lower case hex of data written into out, vectorized
+ * @param data
+ * @param out has to hold 2 * data.size() chars
+ * @return number of chars written
+ * @throws std::length_error if out is too short
+ */
+std::size_t stringToHex(std::span<const unsigned char> data, std::span<char> out);
+
 inline std::string stringToHex(const unsigned char* data, const std::size_t len) {
     std::string s(len * 2, ' ');
-    for (std::size_t i = 0; i < len; ++i) {
-        s[2 * i] = hexMap[(data[i] & 0xF0) >> 4];
-        s[2 * i + 1] = hexMap[data[i] & 0x0F];
-    }
+    stringToHex(std::span(data, len), std::span(s));
     return s;
 }
 
+/**
+ * Decode hex written in lower or upper case into out, vectorized
+ * @param hex
+ * @param out has to hold hex.size() / 2 bytes
+ * @return number of bytes written
+ * @throws std::invalid_argument if hex has an odd length or a char which is not a hex digit
+ * @throws std::length_error if out is too short
+ */
+std::size_t hexToBytes(std::string_view hex, std::span<unsigned char> out);
+
+/**
+ * Decode hex written in lower or upper case
+ * @param hex
+ * @return
+ * @throws std::invalid_argument if hex has an odd length or a char which is not a hex digit
+ */
+inline std::vector<unsigned char> hexToBytes(const std::string_view hex) {
+    std::vector<unsigned char> retVal(hex.size() / 2);
+    hexToBytes(hex, std::span(retVal));
+    return retVal;
+}
+
 /**
  * Pack Date and Time components into MS COM time format (a double)
  * @param year
@@ -114,52 +172,89 @@ inline bool string2bool(std::string v) {
     return !v.empty() && (v == "true" || atoi(v.c_str()) != 0);
 }
 
+/**
+ * Batch variant of daysFromCivil over separate year, month and day arrays
+ * @param years
+ * @param months 1..12
+ * @param days 1..31
+ * @param out days from epoch, converts min of all sizes elements
+ */
+constexpr void daysFromCivil(const std::span<const int> years, const std::span<const int> months,
+                             const std::span<const int> days, const std::span<std::int64_t> out) {
+    const std::size_t count = std::min({years.size(), months.size(), days.size(), out.size()});
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = daysFromCivil(years[i], months[i], days[i]);
+    }
+}
+
 /**
  * Same as std::mktime but does not convert into local time, uses UTC instead
- * @param ptm
+ * @param ptm tm_mon has to be in 0..11, other fields may be out of their range
  * @return
  */
 time_t mkgmtime(const struct tm* ptm);
 
 /**
- * A helper for converting date-time strings into the Unix timestamp (seconds from epoch)
+ * Batch variant of mkgmtime
+ * @param tms
+ * @param out seconds from epoch, converts min of both sizes elements
+ */
+constexpr void mkgmtime(const std::span<const std::tm> tms, const std::span<std::time_t> out) {
+    const std::size_t count = std::min(tms.size(), out.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::tm& tm = tms[i];
+        out[i] = static_cast<std::time_t>(daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday)) * 86400 +
+                 tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+    }
+}
+
+/**
+ * A helper for converting date-time strings into the Unix timestamp (seconds from epoch). Formats supported by
+ * vk::TimeFormat (time_utils.h) are parsed without allocations, others with std::get_time.
+ * Fields parsed before a mismatch are used, as with std::get_time. The time is taken as UTC, a %z offset
+ * is not applied (see getTimeStampFromStringWithZone)
  * @param timeString e.g. "2022-01-28T21:45:00+00:00"
- * @param format e.g. "%Y-%m-%dT%H:%M:%S:%z"
+ * @param format e.g. "%Y-%m-%dT%H:%M:%S%z"
  * @return seconds from epoch
  */
-int64_t getTimeStampFromString(const std::string& timeString, const std::string& format);
+int64_t getTimeStampFromString(std::string_view timeString, std::string_view format);
 
 /**
- * A helper for converting date-time strings into the Unix timestamp (seconds from epoch)
+ * A helper for converting date-time strings into the Unix timestamp (seconds from epoch). Formats supported by
+ * vk::TimeFormat (time_utils.h) are parsed without allocations, others with date::parse
  * @param timeString e.g. "2022-01-28T21:45:00+00:00"
- * @param format e.g. "%Y-%m-%dT%H:%M:%S:%z"
+ * @param format e.g. "%Y-%m-%dT%H:%M:%S%z"
  * @return seconds from epoch
  */
-int64_t getTimeStampFromStringWithZone(const std::string& timeString, const std::string& format);
+int64_t getTimeStampFromStringWithZone(std::string_view timeString, std::string_view format);
 
 /**
- * A helper for converting date-time strings into the tm structure
+ * A helper for converting date-time strings into the tm structure. Formats supported by vk::TimeFormat
+ * (time_utils.h) are parsed without allocations, others with std::get_time
  * @param timeString e.g. "2022-01-28T21:45:00+00:00"
- * @param format e.g. "%Y-%m-%dT%H:%M:%S:%z"
+ * @param format e.g. "%Y-%m-%dT%H:%M:%S%z"
  * @return filled tm structure
  */
-std::tm getTimeFromString(const std::string& timeString, const std::string& format);
+std::tm getTimeFromString(std::string_view timeString, std::string_view format);
 
 /**
- * A helper for converting Unix timestamp (seconds from epoch) into date-time strings
+ * A helper for converting Unix timestamp (seconds from epoch) into date-time strings, thread-safe. Formats supported
+ * by vk::TimeFormat (time_utils.h) go through vk::formatTimeStamp, others through strftime
  * @param timeStamp
  * @param format
- * @param isMs
+ * @param isMs timeStamp is in ms, ".mmm" is appended
  * @return
  */
-std::string getDateTimeStringFromTimeStamp(int64_t timeStamp, const std::string& format, bool isMs = false);
+std::string getDateTimeStringFromTimeStamp(int64_t timeStamp, std::string_view format, bool isMs = false);
 
 /**
- * Convert ISO 8601 date string to milliseconds. Format: "2025-11-29T20:30:13.873Z"
+ * Convert ISO 8601 date string to milliseconds. Format: "2025-11-29T20:30:13.873Z", the fraction is optional
+ * and "Z" may also be an offset like "+01:00"
  * @param dateStr
  * @return Unix time stamp in ms
+ * @throws std::runtime_error if dateStr is not in the format
  */
-std::int64_t convertISOToMilliseconds(const std::string& dateStr);
+std::int64_t convertISOToMilliseconds(std::string_view dateStr);
 
 /**
  * Convert double into string with given precision
@@ -29,68 +29,401 @@
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   Altered for vk_common: table driven scalar code and SSSE3/AVX2 kernels
+   chosen at runtime on x86-64 (define BASE64_NO_SIMD to disable them).
+
 */
 
 #include "base64.h"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
+#if !defined(BASE64_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define BASE64_X86_SIMD
+#include <immintrin.h>
+#endif
+
  //
  // Depending on the url parameter in base64_chars, one of
  // two sets of base64 characters needs to be chosen.
  // They differ in their last two characters.
  //
-static const char* base64_chars[2] = {
+static constexpr char base64_chars_std[] =
              "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
              "abcdefghijklmnopqrstuvwxyz"
              "0123456789"
-             "+/",
+             "+/";
 
+static constexpr char base64_chars_url[] =
              "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
              "abcdefghijklmnopqrstuvwxyz"
              "0123456789"
-             "-_"};
+             "-_";
+
+static const char* base64_chars[2] = {base64_chars_std, base64_chars_url};
+
+static constexpr unsigned char invalid_char = 0xff;
+
+static constexpr std::array<unsigned char, 256> make_decode_table() {
+    std::array<unsigned char, 256> table{};
+    table.fill(invalid_char);
+
+    for (unsigned char i = 0; i < 64; ++i) {
+        table[static_cast<unsigned char>(base64_chars_std[i])] = i;
+        table[static_cast<unsigned char>(base64_chars_url[i])] = i;
+    }
+
+    return table;
+}
+
+ //
+ // Position of each character within base64_chars, both alphabets are
+ // accepted, invalid_char for the others.
+ //
+static constexpr std::array<unsigned char, 256> decode_table = make_decode_table();
 
 static unsigned int pos_of_char(const unsigned char chr) {
  //
  // Return the position of chr within base64_encode()
  //
+ // Be liberal with input and accept both url ('-', '_') and non-url ('+', '/')
+ // base 64 characters.
+ //
+    const unsigned char pos = decode_table[chr];
 
-    if      (chr >= 'A' && chr <= 'Z') return chr - 'A';
-    else if (chr >= 'a' && chr <= 'z') return chr - 'a' + ('Z' - 'A')               + 1;
-    else if (chr >= '0' && chr <= '9') return chr - '0' + ('Z' - 'A') + ('z' - 'a') + 2;
-    else if (chr == '+' || chr == '-') return 62; // Be liberal with input and accept both url ('-') and non-url ('+') base 64 characters (
-    else if (chr == '/' || chr == '_') return 63; // Ditto for '/' and '_'
-    else
+    if (pos == invalid_char)
  //
  // 2020-10-23: Throw std::exception rather than const char*
  //(Pablo Martin-Gomez, https://github.com/Bouska)
  //
-    throw std::runtime_error("Input is not valid base64-encoded data.");
+       throw std::runtime_error("Input is not valid base64-encoded data.");
+
+    return pos;
 }
 
-static std::string insert_linebreaks(std::string str, size_t distance) {
+#ifdef BASE64_X86_SIMD
+ //
+ // Vectorized kernels after W. Mula and D. Lemire, "Faster Base64 Encoding
+ // and Decoding Using AVX2 Instructions" (the same as in aklomp/base64).
+ //
+ // Encoding splits each 3 input bytes into 4 sextets with multiplies and
+ // maps them to characters by adding an offset looked up by pshufb, the
+ // offset depends on the range of the sextet only.
+ //
+ // Decoding validates the characters with two pshufb lookups on the low and
+ // the high nibble, their AND is non zero for characters outside of the
+ // alphabet. Valid characters are mapped back by adding an offset looked up
+ // by the high nibble. The one character whose offset differs from the other
+ // characters of its high nibble ('/' or '_') is patched separately. A block
+ // with any other character (padding, line breaks, mixed alphabets) is left
+ // to the scalar code.
+ //
+struct simd_tables {
+    std::int8_t encode_offset[16];
+    std::int8_t decode_lo[16];
+    std::int8_t decode_hi[16];
+    std::int8_t decode_offset[16];
+    char special_char;
+    std::int8_t special_offset;
+};
+
+static constexpr simd_tables make_simd_tables(const char* chars) {
+    simd_tables t{};
+
+ //
+ // Indices computed by encode_translate(): 0 for 26..51, 1..10 for 52..61,
+ // 11 for 62, 12 for 63 and 13 for 0..25.
+ //
+    t.encode_offset[0] = static_cast<std::int8_t>(chars[26] - 26);
+    for (int i = 1; i <= 10; ++i) {
+        t.encode_offset[i] = static_cast<std::int8_t>(chars[52] - 52);
+    }
+    t.encode_offset[11] = static_cast<std::int8_t>(chars[62] - 62);
+    t.encode_offset[12] = static_cast<std::int8_t>(chars[63] - 63);
+    t.encode_offset[13] = static_cast<std::int8_t>(chars[0]);
+
+    bool has_offset[16]{};
+
+    for (int i = 0; i < 64; ++i) {
+        const int hi = chars[i] >> 4;
+        const auto offset = static_cast<std::int8_t>(i - chars[i]);
+
+        if (!has_offset[hi]) {
+            has_offset[hi] = true;
+            t.decode_offset[hi] = offset;
+        }
+        else if (t.decode_offset[hi] != offset) {
+            t.special_char = chars[i];
+            t.special_offset = offset;
+        }
+    }
+
+ //
+ // Each high nibble 2..7 gets its own bit, 0x10 stands for the high nibbles
+ // without any valid character, all low nibbles have it set.
+ //
+    constexpr std::int8_t hi_bits[16] = {0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x20, 0x40,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10};
+
+    for (int hi = 0; hi < 16; ++hi) {
+        t.decode_hi[hi] = hi_bits[hi];
+    }
+
+    for (int lo = 0; lo < 16; ++lo) {
+        t.decode_lo[lo] = 0x10;
+
+        for (int hi = 2; hi < 8; ++hi) {
+            bool valid = false;
+
+            for (int i = 0; i < 64; ++i) {
+                valid = valid || chars[i] == (hi << 4 | lo);
+            }
+
+            if (!valid) {
+                t.decode_lo[lo] = static_cast<std::int8_t>(t.decode_lo[lo] | hi_bits[hi]);
+            }
+        }
+    }
+
+    return t;
+}
+
+static constexpr simd_tables simd_tables_std = make_simd_tables(base64_chars_std);
+static constexpr simd_tables simd_tables_url = make_simd_tables(base64_chars_url);
+
+static __m128i load_table(const std::int8_t* table) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+}
+
+__attribute__((target("ssse3")))
+static __m128i encode_translate(const __m128i indices, const simd_tables& t) {
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(load_table(t.encode_offset), result), indices);
+}
+
+__attribute__((target("ssse3")))
+static std::size_t encode_ssse3(unsigned char const* in, std::size_t in_len, char* out, const simd_tables& t) {
+    std::size_t pos = 0;
+
+    for (; pos + 16 <= in_len; pos += 12, out += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos));
+        v = _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        const __m128i hi = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        const __m128i lo = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), encode_translate(_mm_or_si128(hi, lo), t));
+    }
+
+    return pos;
+}
+
+__attribute__((target("avx2")))
+static std::size_t encode_avx2(unsigned char const* in, std::size_t in_len, char* out, const simd_tables& t) {
+    std::size_t pos = 0;
+    const __m256i encode_offset = _mm256_broadcastsi128_si256(load_table(t.encode_offset));
+
+    for (; pos + 28 <= in_len; pos += 24, out += 32) {
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos + 12)), 1);
+        v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        const __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)),
+                                              _mm256_set1_epi32(0x04000040));
+        const __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)),
+                                              _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(hi, lo);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_add_epi8(_mm256_shuffle_epi8(encode_offset, result), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), result);
+    }
+
+    return pos;
+}
+
+ //
+ // Decode 16 characters into 12 bytes, 16 bytes are stored. Returns false
+ // without storing anything if a character is not in the alphabet of t.
+ //
+__attribute__((target("ssse3")))
+static bool decode_block_ssse3(const char* in, char* out, const simd_tables& t) {
+    const __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+    const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), nibble_mask);
+    const __m128i lo = _mm_shuffle_epi8(load_table(t.decode_lo), _mm_and_si128(str, nibble_mask));
+    const __m128i hi = _mm_shuffle_epi8(load_table(t.decode_hi), hi_nibbles);
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+
+    const __m128i is_special = _mm_cmpeq_epi8(str, _mm_set1_epi8(t.special_char));
+    const __m128i offset = _mm_or_si128(_mm_andnot_si128(is_special, _mm_shuffle_epi8(load_table(t.decode_offset), hi_nibbles)),
+                                        _mm_and_si128(is_special, _mm_set1_epi8(t.special_offset)));
+    const __m128i values = _mm_add_epi8(str, offset);
+    const __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140)),
+                                          _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)));
+    return true;
+}
+
+ //
+ // Decode 32 characters into 24 bytes, 32 bytes are stored.
+ //
+__attribute__((target("avx2")))
+static bool decode_block_avx2(const char* in, char* out, const simd_tables& t) {
+    const __m256i str = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+    const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+    const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), nibble_mask);
+    const __m256i lo = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(load_table(t.decode_lo)),
+                                           _mm256_and_si256(str, nibble_mask));
+    const __m256i hi = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(load_table(t.decode_hi)), hi_nibbles);
+
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())) != -1) {
+        return false;
+    }
+
+    const __m256i is_special = _mm256_cmpeq_epi8(str, _mm256_set1_epi8(t.special_char));
+    const __m256i offset = _mm256_or_si256(
+        _mm256_andnot_si256(is_special,
+                            _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(load_table(t.decode_offset)), hi_nibbles)),
+        _mm256_and_si256(is_special, _mm256_set1_epi8(t.special_offset)));
+    const __m256i values = _mm256_add_epi8(str, offset);
+    const __m256i merged = _mm256_madd_epi16(_mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+                                             _mm256_set1_epi32(0x00011000));
+    const __m256i packed = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7)));
+    return true;
+}
+
+static char* decode_chunk(const char* encoded, size_t pos, size_t length, char* out);
+
+ //
+ // Iterate over the input in blocks of 32 or 16 characters while out_end
+ // leaves room for the whole store of a block. A block which the kernel
+ // rejects is decoded chunk by chunk by the scalar code. The alphabet of
+ // the last decoded block is tried first. Returns the number of characters
+ // consumed.
+ //
+#define BASE64_DECODE_BLOCKS(block_size, decode_block)                         \
+    const simd_tables* tables[2] = {&simd_tables_std, &simd_tables_url};      \
+    size_t pos = 0;                                                            \
+                                                                               \
+    for (; pos + (block_size) <= length &&                                     \
+           static_cast<size_t>(out_end - out) >= (block_size);                 \
+         pos += (block_size)) {                                                \
+        if (decode_block(encoded + pos, out, *tables[0])) {                    \
+            out += (block_size) / 4 * 3;                                       \
+        }                                                                      \
+        else if (decode_block(encoded + pos, out, *tables[1])) {               \
+            std::swap(tables[0], tables[1]);                                   \
+            out += (block_size) / 4 * 3;                                       \
+        }                                                                      \
+        else {                                                                 \
+            for (size_t chunk = pos; chunk < pos + (block_size); chunk += 4) { \
+                out = decode_chunk(encoded, chunk, length, out);               \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    return pos
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const char* encoded, size_t length, char*& out, const char* out_end) {
+    BASE64_DECODE_BLOCKS(32, decode_block_avx2);
+}
+
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const char* encoded, size_t length, char*& out, const char* out_end) {
+    BASE64_DECODE_BLOCKS(16, decode_block_ssse3);
+}
+
+#undef BASE64_DECODE_BLOCKS
+
+enum class simd_level {
+    none,
+    ssse3,
+    avx2
+};
+
+static simd_level cpu_simd_level() {
+    static const simd_level level = __builtin_cpu_supports("avx2")  ? simd_level::avx2
+                                  : __builtin_cpu_supports("ssse3") ? simd_level::ssse3
+                                                                    : simd_level::none;
+    return level;
+}
+#endif
+
+static size_t first_linebreak(size_t distance, size_t line_pos) {
+ //
+ // Index of the first character which goes to a new line when line_pos
+ // characters are on the current line already.
+ //
+    return line_pos == 0 ? distance : distance - line_pos;
+}
+
+static size_t count_linebreaks(size_t len, size_t distance, size_t line_pos) {
+    const size_t first = first_linebreak(distance, line_pos);
+    return len > first ? (len - first - 1) / distance + 1 : 0;
+}
+
+static size_t insert_linebreaks(char* str, size_t len, size_t distance, size_t& line_pos) {
  //
  // Provided by https://github.com/JomaCorpFX, adapted by me.
  //
-    if (!str.length()) {
-        return "";
+ // Insert '\n' in front of every character which would make a line longer
+ // than distance. The lines are moved from the back, so str needs room
+ // for count_linebreaks() more characters. Returns the new length.
+ //
+    if (len == 0) {
+        return 0;
     }
 
-    size_t pos = distance;
+    const size_t first = first_linebreak(distance, line_pos);
+    size_t breaks = count_linebreaks(len, distance, line_pos);
+    const size_t new_len = len + breaks;
 
-    while (pos < str.size()) {
-        str.insert(pos, "\n");
-        pos += distance + 1;
+    size_t src_end = len;
+    char* dst_end = str + new_len;
+
+    while (breaks > 0) {
+        const size_t line_start = first + (breaks - 1) * distance;
+        const size_t line_len = src_end - line_start;
+
+        dst_end -= line_len;
+        std::memmove(dst_end, str + line_start, line_len);
+        *--dst_end = '\n';
+
+        src_end = line_start;
+        --breaks;
     }
 
-    return str;
+    line_pos = (line_pos + len - 1) % distance + 1;
+    return new_len;
 }
 
+static size_t encode_into(unsigned char const* bytes_to_encode, size_t in_len, char* out, bool url);
+
 template <typename String, unsigned int line_length>
 static std::string encode_with_line_breaks(String s) {
-  return insert_linebreaks(base64_encode(s, false), line_length);
+  const size_t len_encoded = base64_encoded_length(s.length());
+  std::string ret(len_encoded + count_linebreaks(len_encoded, line_length, 0), '\0');
+
+  size_t line_pos = 0;
+  encode_into(reinterpret_cast<const unsigned char*>(s.data()), s.length(), ret.data(), false);
+  insert_linebreaks(ret.data(), len_encoded, line_length, line_pos);
+  return ret;
 }
 
 template <typename String>
@@ -108,10 +441,21 @@ static std::string encode(String s, bool url) {
   return base64_encode(reinterpret_cast<const unsigned char*>(s.data()), s.length(), url);
 }
 
-std::string base64_encode(unsigned char const* bytes_to_encode, size_t in_len, bool url) {
+size_t base64_encoded_length(size_t len) {
+    return (len + 2) / 3 * 4;
+}
 
-    size_t len_encoded = (in_len +2) / 3 * 4;
+std::string base64_encode(unsigned char const* bytes_to_encode, size_t in_len, bool url) {
+    std::string ret(base64_encoded_length(in_len), '\0');
+    encode_into(bytes_to_encode, in_len, ret.data(), url);
+    return ret;
+}
 
+static size_t encode_into(unsigned char const* bytes_to_encode, size_t in_len, char* out, bool url) {
+ //
+ // Encode into out, which has room for base64_encoded_length(in_len)
+ // characters, returns that length.
+ //
     unsigned char trailing_char = url ? '.' : '=';
 
  //
@@ -125,118 +469,192 @@ std::string base64_encode(unsigned char const* bytes_to_encode, size_t in_len, b
  //
     const char* base64_chars_ = base64_chars[url];
 
-    std::string ret;
-    ret.reserve(len_encoded);
+    size_t pos = 0;
 
-    unsigned int pos = 0;
+#ifdef BASE64_X86_SIMD
+    const simd_tables& tables = url ? simd_tables_url : simd_tables_std;
+
+    switch (cpu_simd_level()) {
+       case simd_level::avx2:
+          pos = encode_avx2(bytes_to_encode, in_len, out, tables);
+          break;
+       case simd_level::ssse3:
+          pos = encode_ssse3(bytes_to_encode, in_len, out, tables);
+          break;
+       case simd_level::none:
+          break;
+    }
 
-    while (pos < in_len) {
-        ret.push_back(base64_chars_[(bytes_to_encode[pos + 0] & 0xfc) >> 2]);
+    out += pos / 3 * 4;
+#endif
 
-        if (pos+1 < in_len) {
-           ret.push_back(base64_chars_[((bytes_to_encode[pos + 0] & 0x03) << 4) + ((bytes_to_encode[pos + 1] & 0xf0) >> 4)]);
+    for (; pos + 3 <= in_len; pos += 3, out += 4) {
+        const unsigned int triple = bytes_to_encode[pos] << 16 | bytes_to_encode[pos + 1] << 8 | bytes_to_encode[pos + 2];
+        out[0] = base64_chars_[triple >> 18];
+        out[1] = base64_chars_[triple >> 12 & 0x3f];
+        out[2] = base64_chars_[triple >>  6 & 0x3f];
+        out[3] = base64_chars_[triple       & 0x3f];
+    }
 
-           if (pos+2 < in_len) {
-              ret.push_back(base64_chars_[((bytes_to_encode[pos + 1] & 0x0f) << 2) + ((bytes_to_encode[pos + 2] & 0xc0) >> 6)]);
-              ret.push_back(base64_chars_[  bytes_to_encode[pos + 2] & 0x3f]);
-           }
-           else {
-              ret.push_back(base64_chars_[(bytes_to_encode[pos + 1] & 0x0f) << 2]);
-              ret.push_back(trailing_char);
-           }
-        }
-        else {
+    if (pos + 1 == in_len) {
+        out[0] = base64_chars_[(bytes_to_encode[pos] & 0xfc) >> 2];
+        out[1] = base64_chars_[(bytes_to_encode[pos] & 0x03) << 4];
+        out[2] = static_cast<char>(trailing_char);
+        out[3] = static_cast<char>(trailing_char);
+    }
+    else if (pos + 2 == in_len) {
+        out[0] = base64_chars_[(bytes_to_encode[pos] & 0xfc) >> 2];
+        out[1] = base64_chars_[((bytes_to_encode[pos] & 0x03) << 4) + ((bytes_to_encode[pos + 1] & 0xf0) >> 4)];
+        out[2] = base64_chars_[(bytes_to_encode[pos + 1] & 0x0f) << 2];
+        out[3] = static_cast<char>(trailing_char);
+    }
 
-            ret.push_back(base64_chars_[(bytes_to_encode[pos + 0] & 0x03) << 4]);
-            ret.push_back(trailing_char);
-            ret.push_back(trailing_char);
-        }
+    return base64_encoded_length(in_len);
+}
 
-        pos += 3;
+ //
+ // Decode the chunk of (up to) 4 characters at pos, returns the position
+ // behind the output bytes.
+ //
+ // The chunk might be padded with equal signs or dots in order to make it
+ // 4 bytes in size, but this is not required as per RFC 2045. All chunks
+ // except the last one produce three output bytes, the last chunk produces
+ // at least one and up to three bytes.
+ //
+static char* decode_chunk(const char* encoded, size_t pos, size_t length, char* out) {
+ //
+ // A single character can not be decoded, thrown as std::out_of_range like
+ // encoded_string.at(pos + 1) did before.
+ //
+    if (pos + 1 >= length) {
+       throw std::out_of_range("Input is not valid base64-encoded data.");
     }
 
+    unsigned int pos_of_char_1 = pos_of_char(encoded[pos + 1]);
 
-    return ret;
+ //
+ // Emit the first output byte that is produced in each chunk:
+ //
+    *out++ = static_cast<char>((pos_of_char(encoded[pos]) << 2) + ((pos_of_char_1 & 0x30) >> 4));
+
+    if ((pos + 2 < length) &&     // Check for data that is not padded with equal signs (which is allowed by RFC 2045)
+        encoded[pos + 2] != '=' &&
+        encoded[pos + 2] != '.'   // accept URL-safe base 64 strings, too, so check for '.' also.
+       )
+    {
+    //
+    // Emit a chunk's second byte (which might not be produced in the last chunk).
+    //
+       unsigned int pos_of_char_2 = pos_of_char(encoded[pos + 2]);
+       *out++ = static_cast<char>(((pos_of_char_1 & 0x0f) << 4) + ((pos_of_char_2 & 0x3c) >> 2));
+
+       if ((pos + 3 < length) &&
+           encoded[pos + 3] != '=' &&
+           encoded[pos + 3] != '.'
+          )
+       {
+       //
+       // Emit a chunk's third byte (which might not be produced in the last chunk).
+       //
+          *out++ = static_cast<char>(((pos_of_char_2 & 0x03) << 6) + pos_of_char(encoded[pos + 3]));
+       }
+    }
+
+    return out;
 }
 
-template <typename String>
-static std::string decode(String const& encoded_string, bool remove_linebreaks) {
+static char* decode_into(const char* encoded, size_t length, char* out, const char* out_end) {
  //
- // decode(…) is templated so that it can be used with String = const std::string&
- // or std::string_view (requires at least C++17)
+ // Decode into [out, out_end), which has room for the decoded bytes,
+ // returns the position behind them.
  //
+    size_t pos = 0;
 
-    if (encoded_string.empty()) return std::string();
+#ifdef BASE64_X86_SIMD
+    switch (cpu_simd_level()) {
+       case simd_level::avx2:
+          pos = decode_avx2(encoded, length, out, out_end);
+          break;
+       case simd_level::ssse3:
+          pos = decode_ssse3(encoded, length, out, out_end);
+          break;
+       case simd_level::none:
+          break;
+    }
+#else
+    (void) out_end;
+#endif
 
-    if (remove_linebreaks) {
+    for (; pos < length; pos += 4) {
+       out = decode_chunk(encoded, pos, length, out);
+    }
+
+    return out;
+}
 
-       std::string copy(encoded_string);
+static char* decode_lines(std::string_view encoded, char* out, const char* out_end, char* pending, size_t& pending_len) {
+ //
+ // Decode the chunks of encoded without '\n', the characters of the last
+ // incomplete chunk are kept in pending (of size 4).
+ //
+    size_t pos = 0;
 
-       copy.erase(std::remove(copy.begin(), copy.end(), '\n'), copy.end());
+    while (pos < encoded.length()) {
+       if (pending_len == 0) {
+          const size_t line_end = std::min(encoded.find('\n', pos), encoded.length());
+          const size_t chunks = (line_end - pos) / 4 * 4;
 
-       return base64_decode(copy, false);
+          out = decode_into(encoded.data() + pos, chunks, out, out_end);
+          pos += chunks;
+       }
+
+       for (; pos < encoded.length() && pending_len < 4; ++pos) {
+          if (encoded[pos] != '\n') {
+             pending[pending_len++] = encoded[pos];
+          }
+       }
+
+       if (pending_len == 4) {
+          out = decode_chunk(pending, 0, 4, out);
+          pending_len = 0;
+       }
     }
 
-    size_t length_of_string = encoded_string.length();
-    size_t pos = 0;
+    return out;
+}
 
+template <typename String>
+static std::string decode(String const& encoded_string, bool remove_linebreaks) {
  //
- // The approximate length (bytes) of the decoded string might be one or
- // two bytes smaller, depending on the amount of trailing equal signs
- // in the encoded string. This approximation is needed to reserve
- // enough space in the string to be returned.
+ // decode(…) is templated so that it can be used with String = const std::string&
+ // or std::string_view (requires at least C++17)
  //
-    size_t approx_length_of_decoded_string = length_of_string / 4 * 3;
-    std::string ret;
-    ret.reserve(approx_length_of_decoded_string);
 
-    while (pos < length_of_string) {
-    //
-    // Iterate over encoded input string in chunks. The size of all
-    // chunks except the last one is 4 bytes.
-    //
-    // The last chunk might be padded with equal signs or dots
-    // in order to make it 4 bytes in size as well, but this
-    // is not required as per RFC 2045.
-    //
-    // All chunks except the last one produce three output bytes.
-    //
-    // The last chunk produces at least one and up to three bytes.
-    //
-
-       size_t pos_of_char_1 = pos_of_char(encoded_string.at(pos+1) );
+    if (encoded_string.empty()) return std::string();
 
+    if (remove_linebreaks) {
     //
-    // Emit the first output byte that is produced in each chunk:
+    // Decode line by line instead of copying the string without '\n'.
     //
-       ret.push_back(static_cast<std::string::value_type>( ( (pos_of_char(encoded_string.at(pos+0)) ) << 2 ) + ( (pos_of_char_1 & 0x30 ) >> 4)));
+       std::string ret((encoded_string.length() + 3) / 4 * 3, '\0');
+       const char* out_end = ret.data() + ret.size();
 
-       if ( ( pos + 2 < length_of_string  )       &&  // Check for data that is not padded with equal signs (which is allowed by RFC 2045)
-              encoded_string.at(pos+2) != '='     &&
-              encoded_string.at(pos+2) != '.'         // accept URL-safe base 64 strings, too, so check for '.' also.
-          )
-       {
-       //
-       // Emit a chunk's second byte (which might not be produced in the last chunk).
-       //
-          unsigned int pos_of_char_2 = pos_of_char(encoded_string.at(pos+2) );
-          ret.push_back(static_cast<std::string::value_type>( (( pos_of_char_1 & 0x0f) << 4) + (( pos_of_char_2 & 0x3c) >> 2)));
-
-          if ( ( pos + 3 < length_of_string )     &&
-                 encoded_string.at(pos+3) != '='  &&
-                 encoded_string.at(pos+3) != '.'
-             )
-          {
-          //
-          // Emit a chunk's third byte (which might not be produced in the last chunk).
-          //
-             ret.push_back(static_cast<std::string::value_type>( ( (pos_of_char_2 & 0x03 ) << 6 ) + pos_of_char(encoded_string.at(pos+3))   ));
-          }
+       char pending[4];
+       size_t pending_len = 0;
+       char* out = decode_lines(encoded_string, ret.data(), out_end, pending, pending_len);
+
+       if (pending_len > 0) {
+          out = decode_chunk(pending, 0, pending_len, out);
        }
 
-       pos += 4;
+       ret.resize(static_cast<size_t>(out - ret.data()));
+       return ret;
     }
 
+    std::string ret(base64_decoded_length(encoded_string), '\0');
+    char* out = decode_into(encoded_string.data(), encoded_string.length(), ret.data(), ret.data() + ret.size());
+
+    ret.resize(static_cast<size_t>(out - ret.data()));
     return ret;
 }
 
@@ -280,3 +698,135 @@ std::string base64_decode(std::string_view s, bool remove_linebreaks) {
 }
 
 #endif  // __cplusplus >= 201703L
+
+size_t base64_decoded_length(std::string_view s) {
+ //
+ // Every chunk of 4 characters produces three bytes, except for the last
+ // one which is padded or shorter.
+ //
+    const size_t length = s.length();
+    size_t ret = length / 4 * 3;
+
+    auto is_padding = [&s](size_t pos) { return s[pos] == '=' || s[pos] == '.'; };
+
+    switch (length % 4) {
+       case 0:
+          if (length > 0 && is_padding(length - 2)) {
+             ret -= 2;
+          }
+          else if (length > 0 && is_padding(length - 1)) {
+             ret -= 1;
+          }
+          break;
+       case 2:
+          ret += 1;
+          break;
+       case 3:
+          ret += is_padding(length - 1) ? 1 : 2;
+          break;
+       default:
+          break;
+    }
+
+    return ret;
+}
+
+size_t base64_encode(std::span<const unsigned char> in, std::span<char> out, bool url) {
+   if (out.size() < base64_encoded_length(in.size())) {
+      throw std::length_error("base64_encode: output buffer is too small");
+   }
+
+   return encode_into(in.data(), in.size(), out.data(), url);
+}
+
+size_t base64_decode(std::string_view s, std::span<unsigned char> out) {
+   if (out.size() < base64_decoded_length(s)) {
+      throw std::length_error("base64_decode: output buffer is too small");
+   }
+
+   char* begin = reinterpret_cast<char*>(out.data());
+   return static_cast<size_t>(decode_into(s.data(), s.length(), begin, begin + out.size()) - begin);
+}
+
+base64_encoder::base64_encoder(bool url, size_t line_length) : url_(url), line_length_(line_length) {
+}
+
+size_t base64_encoder::max_output(size_t in_len) const {
+   const size_t len_encoded = base64_encoded_length(pending_len_ + in_len);
+   return line_length_ == 0 ? len_encoded : len_encoded + count_linebreaks(len_encoded, line_length_, line_pos_);
+}
+
+size_t base64_encoder::update(std::span<const unsigned char> in, std::span<char> out) {
+   if (out.size() < max_output(in.size())) {
+      throw std::length_error("base64_encoder: output buffer is too small");
+   }
+
+   size_t pos = 0;
+   size_t len = 0;
+
+   if (pending_len_ > 0) {
+      for (; pos < in.size() && pending_len_ < 3; ++pos) {
+         pending_[pending_len_++] = in[pos];
+      }
+
+      if (pending_len_ < 3) {
+         return 0;
+      }
+
+      len = encode_into(pending_, 3, out.data(), url_);
+      pending_len_ = 0;
+   }
+
+   const size_t whole = (in.size() - pos) / 3 * 3;
+   len += encode_into(in.data() + pos, whole, out.data() + len, url_);
+
+   for (pos += whole; pos < in.size(); ++pos) {
+      pending_[pending_len_++] = in[pos];
+   }
+
+   return line_length_ == 0 ? len : insert_linebreaks(out.data(), len, line_length_, line_pos_);
+}
+
+size_t base64_encoder::finish(std::span<char> out) {
+   if (out.size() < max_output(0)) {
+      throw std::length_error("base64_encoder: output buffer is too small");
+   }
+
+   size_t len = encode_into(pending_, pending_len_, out.data(), url_);
+
+   if (line_length_ != 0) {
+      len = insert_linebreaks(out.data(), len, line_length_, line_pos_);
+   }
+
+   pending_len_ = 0;
+   line_pos_ = 0;
+   return len;
+}
+
+size_t base64_decoder::max_output(size_t in_len) const {
+   return (pending_len_ + in_len + 3) / 4 * 3;
+}
+
+size_t base64_decoder::update(std::string_view in, std::span<unsigned char> out) {
+   if (out.size() < max_output(in.size())) {
+      throw std::length_error("base64_decoder: output buffer is too small");
+   }
+
+   char* begin = reinterpret_cast<char*>(out.data());
+   return static_cast<size_t>(decode_lines(in, begin, begin + out.size(), pending_, pending_len_) - begin);
+}
+
+size_t base64_decoder::finish(std::span<unsigned char> out) {
+   if (out.size() < max_output(0)) {
+      throw std::length_error("base64_decoder: output buffer is too small");
+   }
+
+   if (pending_len_ == 0) {
+      return 0;
+   }
+
+   char* begin = reinterpret_cast<char*>(out.data());
+   const size_t pending_len = pending_len_;
+   pending_len_ = 0;
+   return static_cast<size_t>(decode_chunk(pending_, 0, pending_len, begin) - begin);
+}
@@ -0,0 +1,315 @@
+/**
+HMAC-SHA256 Signer
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include "vk/utils/hmac_sha256.h"
+#include "vk/utils/utils.h"
+#include "base64.h"
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define VK_SHA256_X86
+#include <immintrin.h>
+#endif
+
+namespace vk {
+namespace {
+constexpr std::size_t BLOCK_SIZE = 64;
+
+constexpr std::array<std::uint32_t, 8> INITIAL_STATE = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+alignas(16) constexpr std::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+using State = std::array<std::uint32_t, 8>;
+
+std::uint32_t loadBigEndian(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(p[0]) << 24 | static_cast<std::uint32_t>(p[1]) << 16 |
+           static_cast<std::uint32_t>(p[2]) << 8 | p[3];
+}
+
+void compressScalar(State& state, const std::uint8_t* blocks, std::size_t count) {
+    for (; count > 0; --count, blocks += BLOCK_SIZE) {
+        std::uint32_t w[64];
+
+        for (int i = 0; i < 16; ++i) {
+            w[i] = loadBigEndian(blocks + 4 * i);
+        }
+
+        for (int i = 16; i < 64; ++i) {
+            const std::uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ w[i - 15] >> 3;
+            const std::uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ w[i - 2] >> 10;
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; ++i) {
+            const std::uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+            const std::uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            const std::uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+            const std::uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef VK_SHA256_X86
+/**
+ * Four rounds of SHA-NI compression (after the Intel SHA extensions white paper), message words of the group are in
+ * msg[G % 4], msg[(G + 1) % 4] is completed and msg[(G - 1) % 4] prepared for the later groups
+ */
+template <int G>
+__attribute__((target("sha,sse4.1"), always_inline))
+inline void shaRounds(__m128i& state0, __m128i& state1, __m128i (&msg)[4], const std::uint8_t* block) {
+    if constexpr (G < 4) {
+        const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        msg[G] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * G)), mask);
+    }
+
+    __m128i words = _mm_add_epi32(msg[G % 4], _mm_load_si128(reinterpret_cast<const __m128i*>(K + 4 * G)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+
+    if constexpr (G >= 3 && G < 15) {
+        __m128i& next = msg[(G + 1) % 4];
+        next = _mm_add_epi32(next, _mm_alignr_epi8(msg[G % 4], msg[(G + 3) % 4], 4));
+        next = _mm_sha256msg2_epu32(next, msg[G % 4]);
+    }
+
+    words = _mm_shuffle_epi32(words, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, words);
+
+    if constexpr (G >= 1 && G < 13) {
+        msg[(G + 3) % 4] = _mm_sha256msg1_epu32(msg[(G + 3) % 4], msg[G % 4]);
+    }
+}
+
+template <int... G>
+__attribute__((target("sha,sse4.1"), always_inline))
+inline void shaBlock(__m128i& state0, __m128i& state1, const std::uint8_t* block,
+                     std::integer_sequence<int, G...>) {
+    __m128i msg[4];
+    (shaRounds<G>(state0, state1, msg, block), ...);
+}
+
+__attribute__((target("sha,sse4.1")))
+void compressShaNi(State& state, const std::uint8_t* blocks, std::size_t count) {
+    // The instructions keep the state as ABEF and CDGH
+    const __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xb1);
+    const __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1b);
+    __m128i state0 = _mm_alignr_epi8(dcba, efgh, 8);
+    __m128i state1 = _mm_blend_epi16(efgh, dcba, 0xf0);
+
+    for (; count > 0; --count, blocks += BLOCK_SIZE) {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+        shaBlock(state0, state1, blocks, std::make_integer_sequence<int, 16>());
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), _mm_blend_epi16(feba, state1, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), _mm_alignr_epi8(state1, feba, 8));
+}
+#endif
+
+using CompressFunction = void (*)(State&, const std::uint8_t*, std::size_t);
+
+CompressFunction compressFunction() {
+#ifdef VK_SHA256_X86
+    static const CompressFunction retVal = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")
+                                               ? compressShaNi
+                                               : compressScalar;
+    return retVal;
+#else
+    return compressScalar;
+#endif
+}
+
+/**
+ * Streaming SHA-256 starting from a given state, bytesBefore is the length of the data already hashed into it
+ */
+class Sha256 {
+public:
+    Sha256(const State& state, const std::uint64_t bytesBefore) : m_state(state), m_length(bytesBefore),
+                                                                  m_compress(compressFunction()) {
+    }
+
+    void update(const std::uint8_t* data, std::size_t len) {
+        m_length += len;
+
+        if (m_bufferLen > 0) {
+            const std::size_t n = std::min(len, BLOCK_SIZE - m_bufferLen);
+            std::memcpy(m_buffer + m_bufferLen, data, n);
+            m_bufferLen += n;
+            data += n;
+            len -= n;
+
+            if (m_bufferLen < BLOCK_SIZE) {
+                return;
+            }
+
+            m_compress(m_state, m_buffer, 1);
+            m_bufferLen = 0;
+        }
+
+        if (len >= BLOCK_SIZE) {
+            m_compress(m_state, data, len / BLOCK_SIZE);
+            data += len / BLOCK_SIZE * BLOCK_SIZE;
+            len %= BLOCK_SIZE;
+        }
+
+        std::memcpy(m_buffer, data, len);
+        m_bufferLen = len;
+    }
+
+    void update(const std::string_view data) {
+        update(reinterpret_cast<const std::uint8_t*>(data.data()), data.size());
+    }
+
+    HmacSha256::Digest finish() {
+        const std::uint64_t bitLength = m_length * 8;
+        m_buffer[m_bufferLen++] = 0x80;
+
+        if (m_bufferLen > BLOCK_SIZE - 8) {
+            std::memset(m_buffer + m_bufferLen, 0, BLOCK_SIZE - m_bufferLen);
+            m_compress(m_state, m_buffer, 1);
+            m_bufferLen = 0;
+        }
+
+        std::memset(m_buffer + m_bufferLen, 0, BLOCK_SIZE - 8 - m_bufferLen);
+
+        for (int i = 0; i < 8; ++i) {
+            m_buffer[BLOCK_SIZE - 1 - i] = static_cast<std::uint8_t>(bitLength >> 8 * i);
+        }
+
+        m_compress(m_state, m_buffer, 1);
+
+        HmacSha256::Digest retVal;
+
+        for (std::size_t i = 0; i < m_state.size(); ++i) {
+            retVal[4 * i] = static_cast<std::uint8_t>(m_state[i] >> 24);
+            retVal[4 * i + 1] = static_cast<std::uint8_t>(m_state[i] >> 16);
+            retVal[4 * i + 2] = static_cast<std::uint8_t>(m_state[i] >> 8);
+            retVal[4 * i + 3] = static_cast<std::uint8_t>(m_state[i]);
+        }
+
+        return retVal;
+    }
+
+private:
+    State m_state;
+    std::uint64_t m_length;
+    CompressFunction m_compress;
+    std::uint8_t m_buffer[BLOCK_SIZE]{};
+    std::size_t m_bufferLen = 0;
+};
+
+State padState(const std::uint8_t (&key)[BLOCK_SIZE], const std::uint8_t pad) {
+    std::uint8_t block[BLOCK_SIZE];
+
+    for (std::size_t i = 0; i < BLOCK_SIZE; ++i) {
+        block[i] = key[i] ^ pad;
+    }
+
+    State retVal = INITIAL_STATE;
+    compressFunction()(retVal, block, 1);
+    return retVal;
+}
+}
+
+HmacSha256::HmacSha256(const std::string_view secret) {
+    std::uint8_t key[BLOCK_SIZE]{};
+
+    if (secret.size() > BLOCK_SIZE) {
+        Sha256 sha(INITIAL_STATE, 0);
+        sha.update(secret);
+        const Digest digest = sha.finish();
+        std::memcpy(key, digest.data(), digest.size());
+    }
+    else {
+        std::memcpy(key, secret.data(), secret.size());
+    }
+
+    m_innerState = padState(key, 0x36);
+    m_outerState = padState(key, 0x5c);
+}
+
+HmacSha256::Digest HmacSha256::sign(const std::string_view message) const {
+    return sign({message});
+}
+
+HmacSha256::Digest HmacSha256::sign(const std::initializer_list<std::string_view> parts) const {
+    Sha256 inner(m_innerState, BLOCK_SIZE);
+
+    for (const auto& part : parts) {
+        inner.update(part);
+    }
+
+    const Digest innerDigest = inner.finish();
+    Sha256 outer(m_outerState, BLOCK_SIZE);
+    outer.update(innerDigest.data(), innerDigest.size());
+    return outer.finish();
+}
+
+std::string_view HmacSha256::signHex(const std::string_view message, HexBuffer& out) const {
+    return toHex(sign(message), out);
+}
+
+std::string_view HmacSha256::signBase64(const std::string_view message, Base64Buffer& out, const bool url) const {
+    return toBase64(sign(message), out, url);
+}
+
+std::string HmacSha256::signHex(const std::string_view message) const {
+    HexBuffer out;
+    return std::string(signHex(message, out));
+}
+
+std::string HmacSha256::signBase64(const std::string_view message, const bool url) const {
+    Base64Buffer out;
+    return std::string(signBase64(message, out, url));
+}
+
+std::string_view HmacSha256::toHex(const Digest& digest, HexBuffer& out) {
+    return {out.data(), stringToHex(std::span(digest), std::span(out))};
+}
+
+std::string_view HmacSha256::toBase64(const Digest& digest, Base64Buffer& out, const bool url) {
+    return {out.data(), base64_encode(std::span(digest), std::span(out), url)};
+}
+}
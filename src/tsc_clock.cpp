@@ -0,0 +1,202 @@
+/**
+TSC Clock
+
+Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+SPDX-License-Identifier: MIT
+Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
+*/
+
+#include "vk/utils/tsc_clock.h"
+#include <mutex>
+#include <thread>
+#include <cmath>
+
+#if defined(VK_TSC_CLOCK_X86) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+namespace vk {
+namespace {
+using namespace std::chrono;
+
+enum class State {
+    Uncalibrated,
+    Tsc,
+    SystemClock
+};
+
+/// Guards everything below, the published calibration is read lock-free by TscClock::now()
+std::mutex g_calibrationMutex;
+State g_state = State::Uncalibrated;
+
+#ifdef VK_TSC_CLOCK_X86
+constexpr auto CALIBRATION_PERIOD = milliseconds(10);
+
+/// Largest relative change of the scale accepted on recalibration, bigger ones mean system_clock was stepped
+constexpr double MAX_SCALE_CHANGE = 0.01;
+
+struct Sample {
+    std::uint64_t tsc = 0;
+    std::int64_t ns = 0;
+};
+
+Sample g_base;
+std::uint64_t g_scale = 0;
+
+bool hasInvariantTsc() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+
+    if (static_cast<unsigned>(regs[0]) < 0x80000007) {
+        return false;
+    }
+
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & 1 << 8) != 0;
+#else
+    unsigned eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+
+    return (edx & 1u << 8) != 0;
+#endif
+}
+
+/**
+ * Read system_clock between two TSC reads, the narrowest of a few tries is taken to filter out preemptions
+ * @return system_clock ns paired with the TSC in the middle
+ */
+Sample sample() {
+    Sample retVal;
+    std::uint64_t bestSpread = UINT64_MAX;
+
+    for (int i = 0; i < 5; ++i) {
+        const std::uint64_t before = __rdtsc();
+        const auto now = system_clock::now();
+        const std::uint64_t after = __rdtsc();
+
+        if (after - before < bestSpread) {
+            bestSpread = after - before;
+            retVal.tsc = before + bestSpread / 2;
+            retVal.ns = duration_cast<nanoseconds>(now.time_since_epoch()).count();
+        }
+    }
+
+    return retVal;
+}
+
+/**
+ * @return ns per cycle between the samples in 32.32 fixed point, 0 if the samples are unusable
+ */
+std::uint64_t scaleBetween(const Sample& from, const Sample& to) {
+    if (to.tsc <= from.tsc || to.ns <= from.ns) {
+        return 0;
+    }
+
+    const long double scale = std::ldexp(static_cast<long double>(to.ns - from.ns) /
+                                         static_cast<long double>(to.tsc - from.tsc), 32);
+
+    // TSC slower than 250 MHz, not plausible
+    if (scale >= 0x4p32L) {
+        return 0;
+    }
+
+    return static_cast<std::uint64_t>(scale);
+}
+
+TscClock::time_point toTimePoint(const Sample& s) {
+    return TscClock::time_point(duration_cast<TscClock::duration>(nanoseconds(s.ns)));
+}
+#endif
+}
+
+bool TscClock::calibrate() {
+    std::lock_guard lock(g_calibrationMutex);
+
+    if (g_state != State::Uncalibrated) {
+        return g_state == State::Tsc;
+    }
+
+    g_state = State::SystemClock;
+
+#ifdef VK_TSC_CLOCK_X86
+    if (!hasInvariantTsc()) {
+        return false;
+    }
+
+    const Sample first = sample();
+    std::this_thread::sleep_for(CALIBRATION_PERIOD);
+    const Sample second = sample();
+
+    if (const std::uint64_t scale = scaleBetween(first, second); scale != 0) {
+        g_base = second;
+        g_scale = scale;
+        publish(second.tsc, second.ns, scale);
+        g_state = State::Tsc;
+    }
+#endif
+
+    return g_state == State::Tsc;
+}
+
+bool TscClock::isTscUsed() {
+    return calibrate();
+}
+
+TscClock::time_point TscClock::slowNow() noexcept {
+#ifdef VK_TSC_CLOCK_X86
+    try {
+        if (s_sequence.load(std::memory_order_acquire) == 0 && !calibrate()) {
+            return system_clock::now();
+        }
+
+        // Somebody else is recalibrating, do not wait for it
+        std::unique_lock lock(g_calibrationMutex, std::try_to_lock);
+
+        if (!lock.owns_lock() || g_state != State::Tsc) {
+            return system_clock::now();
+        }
+
+        const Sample current = sample();
+
+        // Recalibrated by another thread meanwhile
+        if (current.tsc - g_base.tsc < s_maxCycles.load(std::memory_order_relaxed)) {
+            return toTimePoint(current);
+        }
+
+        // The longer the baseline the more precise the scale, keep the old one if system_clock was stepped
+        if (const std::uint64_t scale = scaleBetween(g_base, current);
+            scale != 0 && std::abs(static_cast<double>(scale) / static_cast<double>(g_scale) - 1.) < MAX_SCALE_CHANGE) {
+            g_scale = scale;
+        }
+
+        g_base = current;
+        publish(current.tsc, current.ns, g_scale);
+        return toTimePoint(current);
+    }
+    catch (...) {
+        return system_clock::now();
+    }
+#else
+    return system_clock::now();
+#endif
+}
+
+void TscClock::publish(const std::uint64_t tsc, const std::int64_t ns, const std::uint64_t scale) noexcept {
+    const std::uint64_t sequence = s_sequence.load(std::memory_order_relaxed);
+    s_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    s_baseTsc.store(tsc, std::memory_order_relaxed);
+    s_baseNs.store(ns, std::memory_order_relaxed);
+    s_scale.store(scale, std::memory_order_relaxed);
+    // cycles in RECALIBRATION_PERIOD, scale is never 0 here
+    s_maxCycles.store((static_cast<std::uint64_t>(nanoseconds(RECALIBRATION_PERIOD).count()) << 32) / scale,
+                      std::memory_order_relaxed);
+
+    s_sequence.store(sequence + 2, std::memory_order_release);
+}
+}
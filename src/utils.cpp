@@ -7,19 +7,51 @@ Copyright (c) 2022 Vitezslav Kot <vitezslav.kot@gmail.com>.
 */
 
 #include "vk/utils/utils.h"
+#include "vk/utils/time_utils.h"
 #include "date.h"
 #include <spdlog/fmt/ostr.h>
 #include <iomanip>
 #include <map>
+#include <optional>
 #include <filesystem>
 #include <regex>
 #include <sstream>
+#include <array>
+#include <bit>
+#include <stdexcept>
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+// AVX2 kernels are compiled with target attributes and chosen at runtime
+#define VK_UTILS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 namespace vk {
 static constexpr int SECONDS_PER_MINUTE = 60;
 static constexpr int SECONDS_PER_HOUR = 3600;
 static constexpr int SECONDS_PER_DAY = 86400;
-static const int DAYS_OF_MONTH[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+static constexpr double MS_PER_DAY = 86400000.;
+static constexpr double OLE_EPOCH = 25569.;
+
+/// 2^52 + 2^51, integers below 2^51 in magnitude added to its bits give this double plus the integer
+static constexpr double INT_TO_DOUBLE_MAGIC = 6755399441055744.;
+static constexpr std::int64_t INT_TO_DOUBLE_MAGIC_BITS = std::bit_cast<std::int64_t>(INT_TO_DOUBLE_MAGIC);
+
+static constexpr unsigned char INVALID_HEX_DIGIT = 0xFF;
+
+static constexpr std::array<unsigned char, 256> HEX_DIGITS = [] {
+   std::array<unsigned char, 256> retVal{};
+   retVal.fill(INVALID_HEX_DIGIT);
+   for (unsigned char i = 0; i < 10; ++i) {
+      retVal['0' + i] = i;
+   }
+   for (unsigned char i = 0; i < 6; ++i) {
+      retVal['a' + i] = 10 + i;
+      retVal['A' + i] = 10 + i;
+   }
+   return retVal;
+}();
 
 double systemTimeToVariantTimeMs(const unsigned short year, const unsigned short month, const unsigned short day,
                                  const unsigned short hour, const unsigned short min, const unsigned short sec,
@@ -35,6 +67,276 @@ double systemTimeToVariantTimeMs(const unsigned short year, const unsigned short
    return dateVal;
 }
 
+#ifdef VK_UTILS_AVX2
+static bool hasAvx2() {
+   static const bool retVal = __builtin_cpu_supports("avx2");
+   return retVal;
+}
+
+/**
+ * AVX2 part of convertTimeMs(timeStamps, dates)
+ * @return number of converted values, a multiple of 4
+ */
+__attribute__((target("avx2")))
+static std::size_t convertTimeMsAvx2(const std::int64_t *timeStamps, DATE *dates, const std::size_t count) {
+   const __m256i magicBits = _mm256_set1_epi64x(INT_TO_DOUBLE_MAGIC_BITS);
+   const __m256d magic = _mm256_set1_pd(INT_TO_DOUBLE_MAGIC);
+   const __m256d msPerDay = _mm256_set1_pd(MS_PER_DAY);
+   const __m256d oleEpoch = _mm256_set1_pd(OLE_EPOCH);
+   std::size_t i = 0;
+   for (; i + 4 <= count; i += 4) {
+      const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(timeStamps + i));
+      const __m256d ms = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(t, magicBits)), magic);
+      const __m256d date = _mm256_add_pd(oleEpoch, _mm256_div_pd(ms, msPerDay));
+      const __m256d isZero = _mm256_cmp_pd(ms, _mm256_setzero_pd(), _CMP_EQ_OQ);
+      _mm256_storeu_pd(dates + i, _mm256_andnot_pd(isZero, date));
+   }
+   return i;
+}
+
+/**
+ * AVX2 part of convertTimeMs(dates, timeStamps)
+ * @return number of converted values, a multiple of 4
+ */
+__attribute__((target("avx2")))
+static std::size_t convertTimeMsAvx2(const DATE *dates, std::int64_t *timeStamps, const std::size_t count) {
+   const __m256i magicBits = _mm256_set1_epi64x(INT_TO_DOUBLE_MAGIC_BITS);
+   const __m256d magic = _mm256_set1_pd(INT_TO_DOUBLE_MAGIC);
+   const __m256d msPerDay = _mm256_set1_pd(MS_PER_DAY);
+   const __m256d oleEpoch = _mm256_set1_pd(OLE_EPOCH);
+   std::size_t i = 0;
+   for (; i + 4 <= count; i += 4) {
+      const __m256d date = _mm256_loadu_pd(dates + i);
+      // adding the magic rounds to the nearest integer
+      const __m256d ms = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(date, oleEpoch), msPerDay), magic);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(timeStamps + i),
+                          _mm256_sub_epi64(_mm256_castpd_si256(ms), magicBits));
+   }
+   return i;
+}
+
+/**
+ * AVX2 part of stringToHex
+ * @return number of converted bytes, a multiple of 32
+ */
+__attribute__((target("avx2")))
+static std::size_t stringToHexAvx2(const unsigned char *in, char *dst, const std::size_t size) {
+   std::size_t i = 0;
+   // PSHUFB looks the nibbles up in the digits, unpacking interleaves them per 128-bit lane
+   const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hexMap)));
+   const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+   for (; i + 32 <= size; i += 32) {
+      const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+      const __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibbleMask));
+      const __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, nibbleMask));
+      const __m256i first = _mm256_unpacklo_epi8(hi, lo);
+      const __m256i second = _mm256_unpackhi_epi8(hi, lo);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+   }
+   return i;
+}
+
+/**
+ * 32 hex chars into 16 bytes in the low byte of each 16-bit lane
+ * @param valid bits of invalid chars are cleared
+ */
+__attribute__((target("avx2"), always_inline))
+static inline __m256i decodeHexAvx2(const __m256i chars, int &valid) {
+   // Unsigned range checks as signed compares of values shifted by 0x80
+   const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+   const __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+   const __m256i letter = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+   const __m256i isDigit = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0x80 + 10)),
+                                             _mm256_xor_si256(digit, bias));
+   const __m256i isLetter = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0x80 + 6)),
+                                              _mm256_xor_si256(letter, bias));
+   valid &= _mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter));
+   const __m256i letterValue = _mm256_add_epi8(letter, _mm256_set1_epi8(10));
+   const __m256i nibbles = _mm256_or_si256(_mm256_and_si256(isDigit, digit), _mm256_and_si256(isLetter, letterValue));
+   // pairs of nibbles into bytes, high nibble first
+   return _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+}
+
+/**
+ * AVX2 part of hexToBytes
+ * @return number of converted bytes, a multiple of 32, stops before a block with an invalid char
+ */
+__attribute__((target("avx2")))
+static std::size_t hexToBytesAvx2(const unsigned char *in, unsigned char *dst, const std::size_t count) {
+   std::size_t i = 0;
+   for (; i + 32 <= count; i += 32) {
+      const auto *chars = reinterpret_cast<const __m256i *>(in + 2 * i);
+      int valid = -1;
+      const __m256i first = decodeHexAvx2(_mm256_loadu_si256(chars), valid);
+      const __m256i second = decodeHexAvx2(_mm256_loadu_si256(chars + 1), valid);
+      if (valid != -1) {
+         return i;
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                          _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8));
+   }
+   return i;
+}
+#endif
+
+void convertTimeMs(const std::span<const std::int64_t> timeStamps, const std::span<DATE> dates) {
+   const std::size_t count = std::min(timeStamps.size(), dates.size());
+   std::size_t i = 0;
+
+#ifdef VK_UTILS_AVX2
+   if (hasAvx2()) {
+      i = convertTimeMsAvx2(timeStamps.data(), dates.data(), count);
+   }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+   const __m128i magicBits = _mm_set1_epi64x(INT_TO_DOUBLE_MAGIC_BITS);
+   const __m128d magic = _mm_set1_pd(INT_TO_DOUBLE_MAGIC);
+   const __m128d msPerDay = _mm_set1_pd(MS_PER_DAY);
+   const __m128d oleEpoch = _mm_set1_pd(OLE_EPOCH);
+   for (; i + 2 <= count; i += 2) {
+      const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(timeStamps.data() + i));
+      const __m128d ms = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(t, magicBits)), magic);
+      const __m128d date = _mm_add_pd(oleEpoch, _mm_div_pd(ms, msPerDay));
+      const __m128d isZero = _mm_cmpeq_pd(ms, _mm_setzero_pd());
+      _mm_storeu_pd(dates.data() + i, _mm_andnot_pd(isZero, date));
+   }
+#endif
+
+   for (; i < count; ++i) {
+      dates[i] = convertTimeMs(timeStamps[i]);
+   }
+}
+
+void convertTimeMs(const std::span<const DATE> dates, const std::span<std::int64_t> timeStamps) {
+   const std::size_t count = std::min(dates.size(), timeStamps.size());
+   std::size_t i = 0;
+
+#ifdef VK_UTILS_AVX2
+   if (hasAvx2()) {
+      i = convertTimeMsAvx2(dates.data(), timeStamps.data(), count);
+   }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+   const __m128i magicBits = _mm_set1_epi64x(INT_TO_DOUBLE_MAGIC_BITS);
+   const __m128d magic = _mm_set1_pd(INT_TO_DOUBLE_MAGIC);
+   const __m128d msPerDay = _mm_set1_pd(MS_PER_DAY);
+   const __m128d oleEpoch = _mm_set1_pd(OLE_EPOCH);
+   for (; i + 2 <= count; i += 2) {
+      const __m128d date = _mm_loadu_pd(dates.data() + i);
+      // adding the magic rounds to the nearest integer
+      const __m128d ms = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(date, oleEpoch), msPerDay), magic);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(timeStamps.data() + i),
+                       _mm_sub_epi64(_mm_castpd_si128(ms), magicBits));
+   }
+#endif
+
+   for (; i < count; ++i) {
+      const double ms = (dates[i] - OLE_EPOCH) * MS_PER_DAY + INT_TO_DOUBLE_MAGIC;
+      timeStamps[i] = std::bit_cast<std::int64_t>(ms) - INT_TO_DOUBLE_MAGIC_BITS;
+   }
+}
+
+std::size_t stringToHex(const std::span<const unsigned char> data, const std::span<char> out) {
+   if (out.size() < 2 * data.size()) {
+      throw std::length_error("stringToHex: output is too short");
+   }
+
+   const unsigned char *in = data.data();
+   char *dst = out.data();
+   std::size_t i = 0;
+
+#ifdef VK_UTILS_AVX2
+   if (hasAvx2()) {
+      i = stringToHexAvx2(in, dst, data.size());
+   }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+   // Without PSHUFB the nibbles become digits by adding '0' and another 'a' - '0' - 10 to those above 9
+   const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+   const auto toDigits = [](const __m128i nibbles) {
+      const __m128i isLetter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+      return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                          _mm_and_si128(isLetter, _mm_set1_epi8('a' - '0' - 10)));
+   };
+   for (; i + 16 <= data.size(); i += 16) {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+      const __m128i hi = toDigits(_mm_and_si128(_mm_srli_epi16(bytes, 4), nibbleMask));
+      const __m128i lo = toDigits(_mm_and_si128(bytes, nibbleMask));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+   }
+#endif
+
+   for (; i < data.size(); ++i) {
+      dst[2 * i] = hexMap[in[i] >> 4];
+      dst[2 * i + 1] = hexMap[in[i] & 0x0F];
+   }
+
+   return 2 * data.size();
+}
+
+std::size_t hexToBytes(const std::string_view hex, const std::span<unsigned char> out) {
+   if (hex.size() % 2 != 0) {
+      throw std::invalid_argument("hexToBytes: odd length");
+   }
+
+   const std::size_t count = hex.size() / 2;
+
+   if (out.size() < count) {
+      throw std::length_error("hexToBytes: output is too short");
+   }
+
+   const auto *in = reinterpret_cast<const unsigned char *>(hex.data());
+   unsigned char *dst = out.data();
+   std::size_t i = 0;
+
+#ifdef VK_UTILS_AVX2
+   if (hasAvx2()) {
+      i = hexToBytesAvx2(in, dst, count);
+   }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+   const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+   for (; i + 16 <= count; i += 16) {
+      const auto decode = [&](const __m128i chars, int &valid) {
+         const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+         const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+         const __m128i isDigit = _mm_cmplt_epi8(_mm_xor_si128(digit, bias),
+                                                _mm_set1_epi8(static_cast<char>(0x80 + 10)));
+         const __m128i isLetter = _mm_cmplt_epi8(_mm_xor_si128(letter, bias),
+                                                 _mm_set1_epi8(static_cast<char>(0x80 + 6)));
+         valid &= _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter));
+         const __m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, digit),
+                                              _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+         // pairs of nibbles into bytes, high nibble first, the low byte of each 16-bit lane keeps the result
+         return _mm_and_si128(_mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8)),
+                              _mm_set1_epi16(0x00FF));
+      };
+      int valid = 0xFFFF;
+      const __m128i first = decode(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i)), valid);
+      const __m128i second = decode(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i + 16)), valid);
+      if (valid != 0xFFFF) {
+         break;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(first, second));
+   }
+#endif
+
+   // also finds the invalid char of a rejected block
+   for (; i < count; ++i) {
+      const unsigned char hi = HEX_DIGITS[in[2 * i]];
+      const unsigned char lo = HEX_DIGITS[in[2 * i + 1]];
+      if (hi == INVALID_HEX_DIGIT || lo == INVALID_HEX_DIGIT) {
+         const std::size_t pos = hi == INVALID_HEX_DIGIT ? 2 * i : 2 * i + 1;
+         throw std::invalid_argument("hexToBytes: invalid hex digit at " + std::to_string(pos));
+      }
+      dst[i] = static_cast<unsigned char>(hi << 4 | lo);
+   }
+
+   return count;
+}
+
 size_t strlcpy(char *dst, const char *src, const size_t dsize) {
    const char *osrc = src;
    size_t nleft = dsize;
@@ -67,27 +369,9 @@ std::vector<std::string> splitString(const std::string &s, const char delim) {
    return elems;
 }
 
-inline bool isLeapYear(const short year) {
-   if (year % 4 != 0) return false;
-   if (year % 100 != 0) return true;
-   return year % 400 == 0;
-}
-
 time_t mkgmtime(const tm *ptm) {
-   time_t secs = 0;
-   // tm_year is years since 1900
-   const int year = ptm->tm_year + 1900;
-   for (int y = 1970; y < year; ++y) {
-      secs += (isLeapYear(static_cast<short>(y)) ? 366 : 365) * SECONDS_PER_DAY;
-   }
-   // tm_mon is month from 0..11
-   for (int m = 0; m < ptm->tm_mon; ++m) {
-      secs += DAYS_OF_MONTH[m] * SECONDS_PER_DAY;
-      if (m == 1 && isLeapYear(static_cast<short>(year))) {
-         secs += SECONDS_PER_DAY;
-      }
-   }
-   secs += (ptm->tm_mday - 1) * SECONDS_PER_DAY;
+   // tm_year is years since 1900, tm_mon is month from 0..11
+   time_t secs = static_cast<time_t>(daysFromCivil(ptm->tm_year + 1900, ptm->tm_mon + 1, ptm->tm_mday)) * SECONDS_PER_DAY;
    secs += ptm->tm_hour * SECONDS_PER_HOUR;
    secs += ptm->tm_min * SECONDS_PER_MINUTE;
    secs += ptm->tm_sec;
@@ -95,52 +379,102 @@ time_t mkgmtime(const tm *ptm) {
    return secs;
 }
 
-int64_t getTimeStampFromString(const std::string &timeString, const std::string &format) {
+/**
+ * Compiled format from a per thread cache of the last used formats, nullptr if TimeFormat does not support it.
+ * Unsupported formats are cached as well, so they go to the fallback without compiling again.
+ */
+static const TimeFormat *compileTimeFormat(const std::string_view format) {
+   static constexpr std::size_t MAX_CACHED_FORMATS = 16;
+   static thread_local std::map<std::string, std::optional<TimeFormat>, std::less<>> cache;
+
+   auto it = cache.find(format);
+
+   if (it == cache.end()) {
+      if (cache.size() == MAX_CACHED_FORMATS) {
+         cache.clear();
+      }
+
+      it = cache.emplace(format, TimeFormat::tryCompile(format)).first;
+   }
+
+   return it->second ? &*it->second : nullptr;
+}
+
+int64_t getTimeStampFromString(const std::string_view timeString, const std::string_view format) {
+   if (const TimeFormat *compiled = compileTimeFormat(format)) {
+      TimeFields fields;
+      compiled->parse(timeString, fields);
+      // %z is parsed but not applied, std::get_time does not apply it either
+      return fields.toSeconds() + fields.utcOffset;
+   }
+
    std::tm time{};
-   std::istringstream ss(timeString);
-   ss >> std::get_time(&time, format.c_str());
+   std::istringstream ss{std::string(timeString)};
+   ss >> std::get_time(&time, std::string(format).c_str());
    return mkgmtime(&time);
 }
 
-int64_t getTimeStampFromStringWithZone(const std::string &timeString, const std::string &format) {
-   std::istringstream ss(timeString);
+int64_t getTimeStampFromStringWithZone(const std::string_view timeString, const std::string_view format) {
+   if (const TimeFormat *compiled = compileTimeFormat(format)) {
+      TimeFields fields;
+      compiled->parse(timeString, fields);
+      return fields.toSeconds();
+   }
+
+   std::istringstream ss{std::string(timeString)};
    std::chrono::sys_seconds dt;
-   ss >> date::parse(format, dt);
+   ss >> date::parse(std::string(format), dt);
    return dt.time_since_epoch().count();
 }
 
-std::tm getTimeFromString(const std::string &timeString, const std::string &format) {
+std::tm getTimeFromString(const std::string_view timeString, const std::string_view format) {
+   if (const TimeFormat *compiled = compileTimeFormat(format)) {
+      TimeFields fields;
+      compiled->parse(timeString, fields);
+      return fields.toTm();
+   }
+
    std::tm time{};
-   std::istringstream ss(timeString);
-   ss >> std::get_time(&time, format.c_str());
+   std::istringstream ss{std::string(timeString)};
+   ss >> std::get_time(&time, std::string(format).c_str());
    return time;
 }
 
-std::string getDateTimeStringFromTimeStamp(const int64_t timeStamp, const std::string &format, const bool isMs) {
-   std::string retVal;
-   std::time_t secsSinceEpoch;
-   std::time_t ms = 0;
+std::string getDateTimeStringFromTimeStamp(const int64_t timeStamp, const std::string_view format, const bool isMs) {
+   if (const TimeFormat *compiled = compileTimeFormat(format)) {
+      char timeString[TimeFormat::MAX_FORMATTED_SIZE];
+      return {timeString, formatTimeStamp(*compiled, timeStamp, isMs, timeString)};
+   }
+
+   std::time_t secsSinceEpoch = timeStamp;
+   int ms = 0;
 
-   if (!isMs) {
-      secsSinceEpoch = timeStamp;
-   } else {
+   if (isMs) {
       secsSinceEpoch = timeStamp / 1000;
-      ms = timeStamp % 1000;
+      ms = static_cast<int>(timeStamp % 1000);
+      if (ms < 0) {
+         --secsSinceEpoch;
+         ms += 1000;
+      }
    }
 
-   auto timeStruct = std::gmtime(&secsSinceEpoch);
+   std::tm timeStruct{};
+#ifdef _WIN32
+   gmtime_s(&timeStruct, &secsSinceEpoch);
+#else
+   gmtime_r(&secsSinceEpoch, &timeStruct);
+#endif
    char timeString[128];
-   std::strftime(timeString, 128, format.c_str(), timeStruct);
-   retVal.append(timeString);
+   std::size_t size = std::strftime(timeString, sizeof(timeString) - 4, std::string(format).c_str(), &timeStruct);
 
    if (isMs) {
-      std::string msString(timeString);
-      msString.append(".");
-      msString.append(std::to_string(ms));
-      retVal = msString;
+      timeString[size++] = '.';
+      timeString[size++] = static_cast<char>('0' + ms / 100);
+      timeString[size++] = static_cast<char>('0' + ms / 10 % 10);
+      timeString[size++] = static_cast<char>('0' + ms % 10);
    }
 
-   return retVal;
+   return {timeString, size};
 }
 
 std::string formatDouble(const int64_t precision, const double val) {
@@ -226,29 +560,14 @@ std::vector<std::filesystem::path> findFilePaths(const std::string &dirPath, con
    return retVal;
 }
 
-std::int64_t convertISOToMilliseconds(const std::string &dateStr) {
-   int y, m, d, h, min, s, ms;
+std::int64_t convertISOToMilliseconds(const std::string_view dateStr) {
+   TimeFields fields;
 
-   if (std::sscanf(dateStr.c_str(), "%d-%d-%dT%d:%d:%d.%dZ", &y, &m, &d, &h, &min, &s, &ms) != 7) {
+   if (!parseTime<"%Y-%m-%dT%H:%M:%S%z">(dateStr, fields)) {
       throw std::runtime_error(fmt::format("Error parsing date string: {}", dateStr));
    }
 
-   std::tm tm = {};
-   tm.tm_year = y - 1900;
-   tm.tm_mon = m - 1;
-   tm.tm_mday = d;
-   tm.tm_hour = h;
-   tm.tm_min = min;
-   tm.tm_sec = s;
-   tm.tm_isdst = 0;  // UTC
-
-#ifdef _WIN32
-   const time_t t = _mkgmtime(&tm);
-#else
-   const time_t t = timegm(&tm);
-#endif
-
-   return t * 1000 + ms;
+   return fields.toMilliseconds();
 }
 
 std::filesystem::path getDocumentsDir() {